@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+#include "analysis_server.hpp"
+#include "directed_graph.hpp"
+#include "graph_generator.hpp"
+
+/*
+ * Throughput of a -g=serve server: --clients connections send --requests
+ * requests each, keeping up to --depth of them in flight, all for the same
+ * generated graph. Without --socket a server is started in this process
+ * on a socket in the temp directory. Requests per second and the
+ * min/median/p99 latencies are reported. With --pipelined=on a stress run
+ * follows, where every client writes all its requests before it reads a
+ * response, so the server has to keep reading while its responses wait.
+ */
+
+namespace {
+
+namespace fs = std::filesystem;
+
+using namespace graphs;
+using namespace graphs::utils;
+
+using OptMap = std::unordered_map<std::string_view, std::string>;
+using Clock = std::chrono::steady_clock;
+using MicroSecs = std::chrono::duration<double, std::micro>;
+
+namespace opts {
+
+constexpr std::string_view Socket = "--socket";
+constexpr std::string_view Clients = "--clients";
+constexpr std::string_view Requests = "--requests";
+constexpr std::string_view Depth = "--depth";
+constexpr std::string_view NumNodes = "--num-nodes";
+constexpr std::string_view NumEdges = "--num-edges";
+constexpr std::string_view Seed = "--seed";
+constexpr std::string_view Analyses = "--analyses";
+constexpr std::string_view DomAlgoOpt = "--dom-algo";
+constexpr std::string_view Jobs = "--jobs";
+constexpr std::string_view Pipelined = "--pipelined";
+
+} // namespace opts
+
+OptMap OptsMap{{opts::Socket, {}},
+               {opts::Clients, "4"},
+               {opts::Requests, "1000"},
+               {opts::Depth, "4"},
+               {opts::NumNodes, "1000"},
+               {opts::NumEdges, "3"},
+               {opts::Seed, "1"},
+               {opts::Analyses, "idom,df"},
+               {opts::DomAlgoOpt, std::string(dom_algo_names::SemiNCA)},
+               {opts::Jobs, std::to_string(ThreadPool::getDefThreadsCount())},
+               {opts::Pipelined, "on"}};
+
+void printHelp(std::ostream &Os = std::cout) {
+  Os << "Usage: dom_frontiers_server_bench [options]\n"
+     << "\t--socket=<>    - socket of a running -g=serve server (a server of "
+        "this process is default).\n"
+     << "\t--clients=<>   - client connections (4 is default).\n"
+     << "\t--requests=<>  - requests of every client (1000 is default).\n"
+     << "\t--depth=<>     - requests in flight per client (4 is default).\n"
+     << "\t--num-nodes=<> - nodes of the generated graph (1000 is "
+        "default).\n"
+     << "\t--num-edges=<> - edges limit of the generated graph (3 is "
+        "default).\n"
+     << "\t--seed=<>      - generator seed (1 is default).\n"
+     << "\t--analyses=<>  - analyses of every request (idom,df is "
+        "default).\n"
+     << "\t--dom-algo=<>  - in-process server: lt, seminca, chk or "
+        "iterative (seminca is default).\n"
+     << "\t--jobs=<>      - in-process server: worker threads (number of "
+        "cores is default).\n"
+     << "\t--pipelined=<> - on: add a run with all the requests of a client "
+        "in flight, off (on is default).\n";
+}
+
+// Nearest-rank percentile of sorted times
+double getPercentile(const std::vector<double> &Times, double Percent) {
+  auto Rank =
+      static_cast<std::size_t>(std::ceil(Percent / 100 * Times.size()));
+  return Times[std::clamp<std::size_t>(Rank, 1, Times.size()) - 1];
+}
+
+// Latencies of the requests of one client, microseconds
+std::vector<double> runClient(const fs::path &SocketPath,
+                              std::string_view Edges, std::size_t ClientIdx,
+                              std::size_t Depth, const OptMap &OM) {
+  auto RequestsCount = std::stoul(OM.at(opts::Requests));
+  const auto &Analyses = OM.at(opts::Analyses);
+
+  AnalysisClient Client(SocketPath);
+  std::unordered_map<std::string, Clock::time_point> Sent;
+  std::vector<double> Latencies;
+  std::size_t SentCount = 0;
+  while (Latencies.size() < RequestsCount) {
+    for (; SentCount < RequestsCount && Sent.size() < Depth; ++SentCount) {
+      auto Id = formatPrint("{}-{}", ClientIdx, SentCount);
+      Sent.emplace(Id, Clock::now());
+      Client.send(Id, Analyses, Edges);
+    }
+    auto Response = Client.receive();
+    if (!Response)
+      throw std::runtime_error("connection closed by the server");
+    if (!Response->Ok)
+      throw std::runtime_error("server error: " + Response->Body);
+    auto SentIt = Sent.find(Response->Id);
+    Latencies.push_back(MicroSecs(Clock::now() - SentIt->second).count());
+    Sent.erase(SentIt);
+  }
+  return Latencies;
+}
+
+// Runs every client at once and prints the CSV row of the run, false if a
+// client has failed
+bool runClients(const fs::path &SocketPath, std::string_view Edges,
+                std::size_t Depth, const OptMap &OM) {
+  auto ClientsCount = std::stoul(OM.at(opts::Clients));
+  std::vector<std::vector<double>> Latencies(ClientsCount);
+  std::vector<std::string> ClientErrors(ClientsCount);
+  auto Start = Clock::now();
+  {
+    std::vector<std::thread> Clients;
+    for (std::size_t Idx = 0; Idx < ClientsCount; ++Idx)
+      Clients.emplace_back([&, Idx] {
+        try {
+          Latencies[Idx] = runClient(SocketPath, Edges, Idx, Depth, OM);
+        } catch (const std::exception &Ex) {
+          ClientErrors[Idx] = Ex.what();
+        }
+      });
+    for (auto &Client : Clients)
+      Client.join();
+  }
+  std::chrono::duration<double> WallTime = Clock::now() - Start;
+
+  for (const auto &Error : ClientErrors)
+    if (!Error.empty()) {
+      std::cerr << formatPrint("Client error: {}", Error) << std::endl;
+      return false;
+    }
+
+  std::vector<double> Times;
+  for (auto &ClientTimes : Latencies)
+    Times.insert(Times.end(), ClientTimes.begin(), ClientTimes.end());
+  std::ranges::sort(Times);
+  std::cout << formatPrint("{},{},{},{},{:.3f},{:.1f},{:.1f},{:.1f},{:.1f}\n",
+                           ClientsCount, Depth, OM.at(opts::NumNodes),
+                           Times.size(), WallTime.count(),
+                           Times.size() / WallTime.count(), Times.front(),
+                           getPercentile(Times, 50), getPercentile(Times, 99));
+  return true;
+}
+
+bool checkArgsOnValidity(std::vector<std::string> &Errors) {
+  auto CheckPositive = [&](std::string_view Option) {
+    const auto &Arg = OptsMap[Option];
+    if (Arg.empty() || Arg.find_first_not_of("0123456789") != Arg.npos ||
+        Arg.size() > 9 || std::stoul(Arg) == 0)
+      Errors.push_back(formatPrint(
+          "Input error: {}=: invalid argument: {}, must be positive", Option,
+          Arg));
+  };
+  for (auto Option : {opts::Clients, opts::Requests, opts::Depth,
+                      opts::NumNodes, opts::NumEdges, opts::Jobs})
+    CheckPositive(Option);
+  if (const auto &Seed = OptsMap[opts::Seed];
+      Seed.empty() || Seed.find_first_not_of("0123456789") != Seed.npos)
+    Errors.push_back(formatPrint(
+        "Input error: {}=: invalid argument: {}, must be a non-negative "
+        "integer",
+        opts::Seed, Seed));
+  if (const auto &Analyses = OptsMap[opts::Analyses];
+      !parseServerAnalyses(Analyses))
+    Errors.push_back(formatPrint("Input error: {}=: unknown analysis: {}",
+                                 opts::Analyses, Analyses));
+  if (const auto &Algo = OptsMap[opts::DomAlgoOpt]; !getDomAlgo(Algo))
+    Errors.push_back(formatPrint("Input error: {}=: unknown algorithm: {}",
+                                 opts::DomAlgoOpt, Algo));
+  if (const auto &Pipelined = OptsMap[opts::Pipelined];
+      Pipelined != "on" && Pipelined != "off")
+    Errors.push_back(formatPrint(
+        "Input error: {}=: invalid argument: {}, must be on or off",
+        opts::Pipelined, Pipelined));
+  return Errors.empty();
+}
+
+} // namespace
+
+int main(int args, char **argv) {
+  std::vector<std::string> Errors;
+  for (std::string_view OptStr : std::ranges::subrange(argv + 1, argv + args)) {
+    if (OptStr == "-h" || OptStr == "-help") {
+      printHelp();
+      return 0;
+    }
+    auto Delimetr = OptStr.find_first_of('=');
+    auto Opt = OptStr.substr(0, Delimetr);
+    if (Delimetr == OptStr.npos || !OptsMap.contains(Opt))
+      Errors.push_back(formatPrint("Input error: invalid option: {}", Opt));
+    else
+      OptsMap[Opt] = OptStr.substr(Delimetr + 1);
+  }
+  if (!checkArgsOnValidity(Errors)) {
+    std::ranges::copy(Errors,
+                      std::ostream_iterator<std::string>(std::cerr, "\n"));
+    return 1;
+  }
+
+  std::ostringstream Graph;
+  DirGraphBuilder::generateGraph(Graph, std::stoul(OptsMap[opts::NumNodes]),
+                                 std::stoul(OptsMap[opts::NumEdges]),
+                                 DirGraphBuilder::DefNodeName,
+                                 std::stoull(OptsMap[opts::Seed]));
+  auto Edges = std::move(Graph).str();
+
+  fs::path SocketPath = OptsMap[opts::Socket];
+  std::optional<AnalysisServer> Server;
+  std::thread ServerThread;
+  if (SocketPath.empty()) {
+    SocketPath = fs::temp_directory_path() /
+                 formatPrint("dom-frontiers-server-bench-{}.sock", ::getpid());
+    Server.emplace(*getDomAlgo(OptsMap[opts::DomAlgoOpt]),
+                   DotStyle{.GraphName = DirectedGraph<int>::DefGraphName,
+                            .NodeShape = DirectedGraph<int>::DefNodeShape,
+                            .NodeColor = DirectedGraph<int>::DefNodeColor,
+                            .EdgeShape = DirectedGraph<int>::DefEdgeShape,
+                            .EdgeColor = DirectedGraph<int>::DefEdgeColor},
+                   std::stoul(OptsMap[opts::Jobs]));
+    ServerThread = std::thread([&] { Server->listen(SocketPath); });
+    // wait until the server accepts connections
+    for (;;) {
+      try {
+        AnalysisClient Probe(SocketPath);
+        break;
+      } catch (const std::runtime_error &) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  }
+
+  std::cout << "clients,depth,nodes,requests,wall_s,requests_per_s,min_us,"
+               "median_us,p99_us\n";
+  bool Succeeded =
+      runClients(SocketPath, Edges, std::stoul(OptsMap[opts::Depth]), OptsMap);
+  if (Succeeded && OptsMap[opts::Pipelined] == "on")
+    Succeeded = runClients(SocketPath, Edges,
+                           std::stoul(OptsMap[opts::Requests]), OptsMap);
+
+  if (Server) {
+    AnalysisClient(SocketPath).sendShutdown();
+    ServerThread.join();
+  }
+  return Succeeded ? 0 : 1;
+}
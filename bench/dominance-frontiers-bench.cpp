@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "directed_graph.hpp"
+#include "dominance_frontier_graph.hpp"
+#include "dominance_tree_graph.hpp"
+#include "edge_list_parser.hpp"
+#include "graph_generator.hpp"
+
+/*
+ * Times every stage of the pipeline separately over sweeps of graph sizes
+ * and shapes. Each (shape, size) graph is generated from --seed once,
+ * then every stage is run --reps times and min/median/p99 are reported:
+ *   parse          - txt file -> edge list,
+ *   graph          - DirectedGraph from the edge list,
+ *   idoms          - immediate dominators with --dom-algo,
+ *   dom-sets       - full DomTable (determineDominators), only for graphs
+ *                    up to --max-dom-sets nodes as it's O(N^2),
+ *   dom-tree       - DomTreeGraph (graph, idoms and tree edges),
+ *   join-graph     - DomJoinGraph (dom-tree plus the join edges pass),
+ *   dom-frontier   - DomFrontierGraph (join-graph plus frontiers),
+ *   dot            - DOT emission of the frontier graph.
+ */
+
+namespace {
+
+namespace fs = std::filesystem;
+
+using namespace graphs;
+using namespace graphs::utils;
+
+using value_type = int;
+using DGT = DirectedGraph<value_type>;
+using DTT = DomTreeGraph<value_type>;
+using DJGT = DomJoinGraph<value_type>;
+using DFT = DomFrontierGraph<value_type>;
+using OptMap = std::unordered_map<std::string_view, std::string>;
+using Clock = std::chrono::steady_clock;
+using MicroSecs = std::chrono::duration<double, std::micro>;
+
+namespace opts {
+
+constexpr std::string_view Sizes = "--sizes";
+constexpr std::string_view Shapes = "--shapes";
+constexpr std::string_view Reps = "--reps";
+constexpr std::string_view NumEdges = "--num-edges";
+constexpr std::string_view DomAlgoOpt = "--dom-algo";
+constexpr std::string_view Seed = "--seed";
+constexpr std::string_view Format = "--format";
+constexpr std::string_view Out = "--out";
+constexpr std::string_view Path = "--path";
+constexpr std::string_view MaxDomSets = "--max-dom-sets";
+
+} // namespace opts
+
+OptMap OptsMap{{opts::Sizes, "1000,10000,100000,1000000"},
+               {opts::Shapes, "random,structured"},
+               {opts::Reps, "5"},
+               {opts::NumEdges, "3"},
+               {opts::DomAlgoOpt, std::string(dom_algo_names::SemiNCA)},
+               {opts::Seed, "1"},
+               {opts::Format, "csv"},
+               {opts::Out, {}},
+               {opts::Path, fs::temp_directory_path().string()},
+               {opts::MaxDomSets, "10000"}};
+
+struct StageResult final {
+  std::string Shape;
+  std::size_t NodesCount = 0;
+  std::size_t EdgesCount = 0;
+  std::string_view Stage;
+  std::vector<double> Times; // microseconds, sorted
+};
+
+void printHelp(std::ostream &Os = std::cout) {
+  Os << "Usage: dom_frontiers_bench [options]\n"
+     << "\t--sizes=<>        - comma separated node counts "
+        "(1000,10000,100000,1000000 is default).\n"
+     << "\t--shapes=<>       - comma separated generator shapes: random, "
+        "structured (both are default).\n"
+     << "\t--reps=<>         - runs of every stage (5 is default).\n"
+     << "\t--num-edges=<>    - edges limit of the random shape (3 is "
+        "default).\n"
+     << "\t--dom-algo=<>     - lt, seminca, chk or iterative (seminca is "
+        "default).\n"
+     << "\t--seed=<>         - generator seed (1 is default).\n"
+     << "\t--format=<>       - csv or json (csv is default).\n"
+     << "\t--out=<>          - results file (stdout is default).\n"
+     << "\t--path=<>         - directory for generated and DOT files (temp "
+        "directory is default).\n"
+     << "\t--max-dom-sets=<> - largest graph to time dom-sets on (10000 is "
+        "default).\n";
+}
+
+std::vector<std::string> splitList(std::string_view List) {
+  std::vector<std::string> Items;
+  for (auto Item : List | std::views::split(','))
+    if (auto Str = std::string(Item.begin(), Item.end()); !Str.empty())
+      Items.push_back(std::move(Str));
+  return Items;
+}
+
+// Nearest-rank percentile of sorted times
+double getPercentile(const std::vector<double> &Times, double Percent) {
+  auto Rank =
+      static_cast<std::size_t>(std::ceil(Percent / 100 * Times.size()));
+  return Times[std::clamp<std::size_t>(Rank, 1, Times.size()) - 1];
+}
+
+class StageTimer final {
+public:
+  StageTimer(std::vector<StageResult> &Results, std::string_view Shape,
+             std::size_t Reps)
+      : Results(Results), Shape(Shape), Reps(Reps) {}
+
+  void setGraphSize(std::size_t Nodes, std::size_t Edges) noexcept {
+    NodesCount = Nodes;
+    EdgesCount = Edges;
+  }
+
+  // Stage runs Reps times, only the calls themselves are timed
+  void run(std::string_view Stage, const std::function<void()> &Fn) {
+    StageResult Result{std::string(Shape), NodesCount, EdgesCount, Stage, {}};
+    for (std::size_t Rep = 0; Rep < Reps; ++Rep) {
+      auto Start = Clock::now();
+      Fn();
+      Result.Times.push_back(MicroSecs(Clock::now() - Start).count());
+    }
+    std::ranges::sort(Result.Times);
+    Results.push_back(std::move(Result));
+  }
+
+private:
+  std::vector<StageResult> &Results;
+  std::string_view Shape;
+  std::size_t Reps;
+  std::size_t NodesCount = 0;
+  std::size_t EdgesCount = 0;
+};
+
+void generateGraph(const fs::path &FilePath, GraphShape Shape,
+                   std::size_t NodeNum, const OptMap &OM) {
+  std::ofstream TxtFile{FilePath};
+  auto Seed = std::stoull(OM.at(opts::Seed));
+  if (Shape == GraphShape::Structured)
+    StructuredGraphBuilder::generateGraph(TxtFile, NodeNum,
+                                          DirGraphBuilder::DefNodeName, Seed);
+  else
+    DirGraphBuilder::generateGraph(TxtFile, NodeNum,
+                                   std::stoul(OM.at(opts::NumEdges)),
+                                   DirGraphBuilder::DefNodeName, Seed);
+}
+
+void benchGraph(StageTimer &Timer, const fs::path &FilePath, DomAlgo Algo,
+                std::size_t MaxDomSets) {
+  auto Edges = readEdgeList(FilePath);
+  auto Begin = Edges.cbegin(), End = Edges.cend();
+  DGT Graph(Begin, End);
+  Timer.setGraphSize(Graph.size(), Edges.size());
+
+  Timer.run("parse", [&] { readEdgeList(FilePath); });
+  Timer.run("graph", [&] { DGT G(Begin, End); });
+  Timer.run("idoms", [&] { Graph.determineImmediateDominators(Algo); });
+  if (Graph.size() <= MaxDomSets)
+    Timer.run("dom-sets", [&] { Graph.determineDominators(Algo); });
+  Timer.run("dom-tree", [&] { DTT G(Begin, End, Algo); });
+  Timer.run("join-graph", [&] { DJGT G(Begin, End, Algo); });
+  Timer.run("dom-frontier", [&] { DFT G(Begin, End, Algo); });
+
+  DFT Front(Begin, End, Algo);
+  auto DotPath = fs::path(FilePath).replace_extension(".dot");
+  Timer.run("dot", [&] {
+    std::ofstream DotFile{DotPath};
+    Front.dumpInDotFormat(DotFile, DGT::DefNodeShape, DGT::DefNodeColor,
+                          DGT::DefEdgeShape, DGT::DefEdgeColor,
+                          DGT::DefGraphName);
+  });
+  fs::remove(DotPath);
+}
+
+void printCSV(const std::vector<StageResult> &Results, std::ostream &Os) {
+  Os << "shape,nodes,edges,stage,reps,min_us,median_us,p99_us\n";
+  for (const auto &R : Results)
+    Os << formatPrint("{},{},{},{},{},{:.1f},{:.1f},{:.1f}\n", R.Shape,
+                      R.NodesCount, R.EdgesCount, R.Stage, R.Times.size(),
+                      R.Times.front(), getPercentile(R.Times, 50),
+                      getPercentile(R.Times, 99));
+}
+
+void printJSON(const std::vector<StageResult> &Results, std::ostream &Os) {
+  Os << "[\n";
+  for (std::size_t Idx = 0; Idx < Results.size(); ++Idx) {
+    const auto &R = Results[Idx];
+    Os << formatPrint("  {{\"shape\": \"{}\", \"nodes\": {}, \"edges\": {}, "
+                      "\"stage\": \"{}\", \"reps\": {}, \"min_us\": {:.1f}, "
+                      "\"median_us\": {:.1f}, \"p99_us\": {:.1f}}}{}\n",
+                      R.Shape, R.NodesCount, R.EdgesCount, R.Stage,
+                      R.Times.size(), R.Times.front(),
+                      getPercentile(R.Times, 50), getPercentile(R.Times, 99),
+                      Idx + 1 < Results.size() ? "," : "");
+  }
+  Os << "]\n";
+}
+
+bool checkArgsOnValidity(std::vector<std::string> &Errors) {
+  auto CheckPositive = [&](std::string_view Option, std::string_view Arg) {
+    if (Arg.empty() || Arg.find_first_not_of("0123456789") != Arg.npos ||
+        Arg.size() > 18 || std::stoull(std::string(Arg)) == 0)
+      Errors.push_back(formatPrint(
+          "Input error: {}=: invalid argument: {}, must be positive", Option,
+          Arg));
+  };
+  for (const auto &Size : splitList(OptsMap[opts::Sizes]))
+    CheckPositive(opts::Sizes, Size);
+  for (const auto &Shape : splitList(OptsMap[opts::Shapes]))
+    if (!getGraphShape(Shape))
+      Errors.push_back(formatPrint("Input error: {}=: unknown shape: {}",
+                                   opts::Shapes, Shape));
+  CheckPositive(opts::Reps, OptsMap[opts::Reps]);
+  CheckPositive(opts::NumEdges, OptsMap[opts::NumEdges]);
+  CheckPositive(opts::MaxDomSets, OptsMap[opts::MaxDomSets]);
+  if (const auto &Seed = OptsMap[opts::Seed];
+      Seed.empty() || Seed.find_first_not_of("0123456789") != Seed.npos)
+    Errors.push_back(formatPrint(
+        "Input error: {}=: invalid argument: {}, must be a non-negative "
+        "integer",
+        opts::Seed, Seed));
+  if (const auto &Algo = OptsMap[opts::DomAlgoOpt]; !getDomAlgo(Algo))
+    Errors.push_back(formatPrint("Input error: {}=: unknown algorithm: {}",
+                                 opts::DomAlgoOpt, Algo));
+  if (const auto &Format = OptsMap[opts::Format];
+      Format != "csv" && Format != "json")
+    Errors.push_back(formatPrint("Input error: {}=: unknown format: {}",
+                                 opts::Format, Format));
+  if (const auto &Path = OptsMap[opts::Path]; !fs::is_directory(Path))
+    Errors.push_back(formatPrint("Input error: {} is invalid path", Path));
+  return Errors.empty();
+}
+
+} // namespace
+
+int main(int args, char **argv) {
+  std::vector<std::string> Errors;
+  for (std::string_view OptStr : std::ranges::subrange(argv + 1, argv + args)) {
+    if (OptStr == "-h" || OptStr == "-help") {
+      printHelp();
+      return 0;
+    }
+    auto Delimetr = OptStr.find_first_of('=');
+    auto Opt = OptStr.substr(0, Delimetr);
+    if (Delimetr == OptStr.npos || !OptsMap.contains(Opt))
+      Errors.push_back(formatPrint("Input error: invalid option: {}", Opt));
+    else
+      OptsMap[Opt] = OptStr.substr(Delimetr + 1);
+  }
+  if (!checkArgsOnValidity(Errors)) {
+    std::ranges::copy(Errors,
+                      std::ostream_iterator<std::string>(std::cerr, "\n"));
+    return 1;
+  }
+
+  auto Algo = *getDomAlgo(OptsMap[opts::DomAlgoOpt]);
+  auto Reps = std::stoul(OptsMap[opts::Reps]);
+  auto MaxDomSets = std::stoul(OptsMap[opts::MaxDomSets]);
+  std::vector<StageResult> Results;
+  for (const auto &ShapeName : splitList(OptsMap[opts::Shapes])) {
+    auto Shape = *getGraphShape(ShapeName);
+    for (const auto &Size : splitList(OptsMap[opts::Sizes])) {
+      auto NodeNum = std::stoul(Size);
+      auto FilePath = fs::path(OptsMap[opts::Path]) /
+                      formatPrint("dom-frontiers-bench-{}-{}.txt", ShapeName,
+                                  NodeNum);
+      generateGraph(FilePath, Shape, NodeNum, OptsMap);
+      std::cerr << formatPrint("{} graph of {} nodes...", ShapeName, NodeNum)
+                << std::endl;
+
+      StageTimer Timer(Results, ShapeName, Reps);
+      benchGraph(Timer, FilePath, Algo, MaxDomSets);
+      fs::remove(FilePath);
+    }
+  }
+
+  std::ofstream OutFile;
+  if (!OptsMap[opts::Out].empty())
+    OutFile.open(OptsMap[opts::Out]);
+  auto &Os = OutFile.is_open() ? static_cast<std::ostream &>(OutFile)
+                               : std::cout;
+  if (OptsMap[opts::Format] == "json")
+    printJSON(Results, Os);
+  else
+    printCSV(Results, Os);
+}
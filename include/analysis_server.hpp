@@ -0,0 +1,583 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "cfg_analyses.hpp"
+#include "dominators.hpp"
+#include "dot_writer.hpp"
+#include "edge_list_parser.hpp"
+#include "statistics.hpp"
+#include "thread_pool.hpp"
+#include "utils.hpp"
+
+/*
+ * A resident analysis server and its client. Requests and responses are
+ * text frames, one per line plus a counted body:
+ *
+ *   request <id> <analysis>[,<analysis>...] <lines>
+ *   <lines "From --> To" edge lines>
+ *
+ *   response <id> ok <lines>
+ *   <lines of body: "[<analysis>]" and its output for every analysis>
+ *
+ *   response <id> error <message>
+ *
+ * The analyses are idom ("node idom" lines, "-" for unreachable nodes),
+ * df ("node: join ..." lines) and the DOT dumps cfg-dot, dom-tree-dot,
+ * join-graph-dot and dom-frontier-dot. Requests of a connection run
+ * concurrently, so responses come in the order they are finished and are
+ * told apart by their ids. "quit" ends the connection, "shutdown" stops a
+ * socket server from accepting new ones.
+ */
+
+namespace graphs {
+
+namespace fs = std::filesystem;
+
+enum class ServerAnalysis : char {
+  IDom,
+  DomFrontier,
+  CfgDot,
+  DomTreeDot,
+  JoinGraphDot,
+  DomFrontierDot
+};
+
+namespace server_analysis_names {
+
+constexpr std::string_view IDom = "idom";
+constexpr std::string_view DomFrontier = "df";
+constexpr std::string_view CfgDot = "cfg-dot";
+constexpr std::string_view DomTreeDot = "dom-tree-dot";
+constexpr std::string_view JoinGraphDot = "join-graph-dot";
+constexpr std::string_view DomFrontierDot = "dom-frontier-dot";
+
+} // namespace server_analysis_names
+
+inline std::optional<ServerAnalysis>
+getServerAnalysis(std::string_view Name) {
+  if (Name == server_analysis_names::IDom)
+    return ServerAnalysis::IDom;
+  if (Name == server_analysis_names::DomFrontier)
+    return ServerAnalysis::DomFrontier;
+  if (Name == server_analysis_names::CfgDot)
+    return ServerAnalysis::CfgDot;
+  if (Name == server_analysis_names::DomTreeDot)
+    return ServerAnalysis::DomTreeDot;
+  if (Name == server_analysis_names::JoinGraphDot)
+    return ServerAnalysis::JoinGraphDot;
+  if (Name == server_analysis_names::DomFrontierDot)
+    return ServerAnalysis::DomFrontierDot;
+  return std::nullopt;
+}
+
+inline std::string_view getServerAnalysisName(ServerAnalysis Analysis) {
+  switch (Analysis) {
+  case ServerAnalysis::IDom:
+    return server_analysis_names::IDom;
+  case ServerAnalysis::DomFrontier:
+    return server_analysis_names::DomFrontier;
+  case ServerAnalysis::CfgDot:
+    return server_analysis_names::CfgDot;
+  case ServerAnalysis::DomTreeDot:
+    return server_analysis_names::DomTreeDot;
+  case ServerAnalysis::JoinGraphDot:
+    return server_analysis_names::JoinGraphDot;
+  case ServerAnalysis::DomFrontierDot:
+  default:
+    return server_analysis_names::DomFrontierDot;
+  }
+}
+
+// "idom,df" -> analyses, std::nullopt if a name is unknown or none is given
+inline std::optional<std::vector<ServerAnalysis>>
+parseServerAnalyses(std::string_view List) {
+  std::vector<ServerAnalysis> Analyses;
+  for (auto Item : List | std::views::split(',')) {
+    auto Analysis =
+        getServerAnalysis(std::string_view(Item.begin(), Item.end()));
+    if (!Analysis)
+      return std::nullopt;
+    Analyses.push_back(*Analysis);
+  }
+  if (Analyses.empty())
+    return std::nullopt;
+  return Analyses;
+}
+
+struct AnalysisRequest final {
+  std::string Id;
+  std::vector<ServerAnalysis> Analyses;
+  std::string Edges; // "From --> To" lines
+};
+
+struct AnalysisResponse final {
+  std::string Id;
+  bool Ok = false;
+  std::string Body; // the error message if not Ok
+};
+
+namespace detail {
+
+// Buffered line input of a file descriptor, lines are given without '\n'
+class FdLineReader final {
+public:
+  explicit FdLineReader(int Fd) : Fd(Fd) {}
+
+  // false at the end of the input
+  bool readLine(std::string &Line) {
+    Line.clear();
+    for (;;) {
+      const char *Begin = Buffer.data() + Pos;
+      if (auto *NewLine =
+              static_cast<const char *>(std::memchr(Begin, '\n', End - Pos))) {
+        Line.append(Begin, NewLine);
+        Pos += NewLine - Begin + 1;
+        return true;
+      }
+      Line.append(Begin, End - Pos);
+      if (!fill())
+        return !Line.empty();
+    }
+  }
+
+  // Appends Count lines to Out, each one with its '\n'
+  bool readLines(std::size_t Count, std::string &Out) {
+    std::string Line;
+    for (; Count; --Count) {
+      if (!readLine(Line))
+        return false;
+      Out.append(Line).push_back('\n');
+    }
+    return true;
+  }
+
+private:
+  bool fill() {
+    ssize_t Got;
+    do
+      Got = ::read(Fd, Buffer.data(), Buffer.size());
+    while (Got < 0 && errno == EINTR);
+    Pos = 0;
+    End = std::max<ssize_t>(Got, 0);
+    return Got > 0;
+  }
+
+  int Fd;
+  std::array<char, 1 << 16> Buffer;
+  std::size_t Pos = 0;
+  std::size_t End = 0;
+};
+
+inline bool writeAll(int Fd, std::string_view Data) {
+  while (!Data.empty()) {
+    auto Written = ::write(Fd, Data.data(), Data.size());
+    if (Written < 0 && errno == EINTR)
+      continue;
+    if (Written <= 0)
+      return false;
+    Data.remove_prefix(Written);
+  }
+  return true;
+}
+
+inline std::size_t countLines(std::string_view Text) {
+  auto Count = static_cast<std::size_t>(std::ranges::count(Text, '\n'));
+  return Text.empty() || Text.back() == '\n' ? Count : Count + 1;
+}
+
+inline std::string makeErrorFrame(std::string_view Id,
+                                  std::string_view Message) {
+  return utils::formatPrint("response {} error {}\n", Id.empty() ? "-" : Id,
+                            Message);
+}
+
+inline sockaddr_un makeSocketAddress(const fs::path &SocketPath) {
+  sockaddr_un Addr{};
+  Addr.sun_family = AF_UNIX;
+  const auto &Path = SocketPath.native();
+  if (Path.size() >= sizeof(Addr.sun_path))
+    throw std::runtime_error("socket path is too long: " + Path);
+  std::ranges::copy(Path, Addr.sun_path);
+  return Addr;
+}
+
+} // namespace detail
+
+/*
+ * Stays resident and answers analysis requests on a thread pool. Every
+ * worker keeps its own pool resource between requests, so the name tables
+ * of the next graphs are built in memory that is already warm.
+ */
+class AnalysisServer final {
+public:
+  using size_type = std::size_t;
+
+  // The views of Style must outlive the server
+  AnalysisServer(DomAlgo Algo, const DotStyle &Style,
+                 size_type ThreadsCount = ThreadPool::getDefThreadsCount())
+      : Algo(Algo), Style(Style), Pool(ThreadsCount) {}
+
+  AnalysisServer(const AnalysisServer &) = delete;
+  AnalysisServer &operator=(const AnalysisServer &) = delete;
+
+  // Answers the requests of InFd on OutFd until the end of the input or a
+  // "quit" line, returns once every response is written
+  void serve(int InFd, int OutFd) {
+    ResponseWriter Responses(OutFd);
+    PendingCounter Pending;
+    detail::FdLineReader Reader(InFd);
+    for (std::string Line; Reader.readLine(Line);) {
+      if (Line.empty())
+        continue;
+      if (Line == "quit")
+        break;
+      if (Line == "shutdown") {
+        stopListening();
+        break;
+      }
+
+      auto Request = std::make_shared<AnalysisRequest>();
+      std::string Error;
+      auto LinesCount = parseHeader(Line, *Request, Error);
+      // the frame can't be skipped without its size
+      if (!LinesCount) {
+        Responses.write(detail::makeErrorFrame(Request->Id, Error));
+        break;
+      }
+      if (!Reader.readLines(*LinesCount, Request->Edges))
+        break;
+      if (!Error.empty()) {
+        Responses.write(detail::makeErrorFrame(Request->Id, Error));
+        continue;
+      }
+
+      Pending.start();
+      Pool.submit([this, Request, &Responses, &Pending] {
+        Responses.write(handle(*Request));
+        Pending.finish();
+      });
+    }
+    Pending.wait();
+  }
+
+  // Accepts connections on a Unix domain socket, each one is served as by
+  // serve() on its own thread, until a client sends "shutdown". Returns
+  // when every connection is closed.
+  void listen(const fs::path &SocketPath) {
+    auto Addr = detail::makeSocketAddress(SocketPath);
+    int Fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (Fd < 0)
+      throw std::runtime_error("can't create socket: " + SocketPath.string());
+    fs::remove(SocketPath);
+    if (::bind(Fd, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) < 0 ||
+        ::listen(Fd, SOMAXCONN) < 0) {
+      ::close(Fd);
+      throw std::runtime_error("can't listen on socket: " +
+                               SocketPath.string());
+    }
+    // a client gone in the middle of a response must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    ListenFd = Fd;
+    PendingCounter Clients;
+    for (;;) {
+      int ClientFd = ::accept(Fd, nullptr, nullptr);
+      if (ClientFd < 0) {
+        if (errno == EINTR || errno == ECONNABORTED)
+          continue;
+        break;
+      }
+      Clients.start();
+      std::thread([this, ClientFd, &Clients] {
+        GRAPHS_STATS_THREAD();
+        serve(ClientFd, ClientFd);
+        ::close(ClientFd);
+        Clients.finish();
+      }).detach();
+    }
+    Clients.wait();
+    ::close(Fd);
+    fs::remove(SocketPath);
+  }
+
+  // Makes listen() return once the open connections are closed
+  void stopListening() noexcept {
+    if (int Fd = ListenFd.exchange(-1); Fd >= 0)
+      ::shutdown(Fd, SHUT_RDWR);
+  }
+
+  // The response frame of one request, errors included
+  std::string handle(const AnalysisRequest &Request) const {
+    GRAPHS_STATS_PHASE("server.request");
+    static thread_local std::pmr::unsynchronized_pool_resource Arena;
+    try {
+      auto Graph = parseCSRGraph(Request.Edges, &Arena);
+      if (Graph.size() == 0)
+        return detail::makeErrorFrame(Request.Id, "no edges");
+
+      CfgAnalyses Analyses(std::move(Graph), Algo);
+      std::ostringstream Body;
+      for (auto Analysis : Request.Analyses) {
+        Body << '[' << getServerAnalysisName(Analysis) << "]\n";
+        writeAnalysis(Body, Analyses, Analysis);
+      }
+      HandledCount.fetch_add(1, std::memory_order_relaxed);
+
+      auto Text = std::move(Body).str();
+      return utils::formatPrint("response {} ok {}\n", Request.Id,
+                                detail::countLines(Text)) +
+             Text;
+    } catch (const std::exception &Ex) {
+      return detail::makeErrorFrame(Request.Id, Ex.what());
+    }
+  }
+
+  size_type getHandledCount() const noexcept {
+    return HandledCount.load(std::memory_order_relaxed);
+  }
+
+private:
+  // Requests (or connections) still running: start() before one is
+  // submitted, finish() once it's done
+  class PendingCounter final {
+  public:
+    void start() {
+      std::lock_guard Lock{Mutex};
+      ++Pending;
+    }
+
+    void finish() {
+      std::lock_guard Lock{Mutex};
+      if (--Pending == 0)
+        AllDone.notify_all();
+    }
+
+    void wait() {
+      std::unique_lock Lock{Mutex};
+      AllDone.wait(Lock, [this] { return Pending == 0; });
+    }
+
+  private:
+    std::mutex Mutex;
+    std::condition_variable AllDone;
+    size_type Pending = 0;
+  };
+
+  // Responses of one connection. Workers queue whole frames and a writer
+  // thread writes them out with no lock held, so a client that reads its
+  // responses late blocks only the writer, not the workers or the reading
+  // of its next requests. The queued frames are written before the
+  // destructor returns.
+  class ResponseWriter final {
+  public:
+    explicit ResponseWriter(int OutFd)
+        : OutFd(OutFd), Writer([this] { run(); }) {}
+
+    ResponseWriter(const ResponseWriter &) = delete;
+    ResponseWriter &operator=(const ResponseWriter &) = delete;
+
+    ~ResponseWriter() {
+      {
+        std::lock_guard Lock{Mutex};
+        Closed = true;
+      }
+      Ready.notify_one();
+      Writer.join();
+    }
+
+    void write(std::string Frame) {
+      {
+        std::lock_guard Lock{Mutex};
+        Frames.push_back(std::move(Frame));
+      }
+      Ready.notify_one();
+    }
+
+  private:
+    void run() {
+      GRAPHS_STATS_THREAD();
+      std::unique_lock Lock{Mutex};
+      for (;;) {
+        Ready.wait(Lock, [this] { return !Frames.empty() || Closed; });
+        if (Frames.empty())
+          return;
+        auto Batch = std::exchange(Frames, {});
+        Lock.unlock();
+        // the rest is dropped once the client is gone
+        for (const auto &Frame : Batch)
+          Broken = Broken || !detail::writeAll(OutFd, Frame);
+        Lock.lock();
+      }
+    }
+
+    int OutFd;
+    bool Broken = false;
+    std::mutex Mutex;
+    std::condition_variable Ready;
+    std::vector<std::string> Frames;
+    bool Closed = false;
+    std::thread Writer;
+  };
+
+  // "request <id> <analyses> <lines>": the body size, or std::nullopt if
+  // the line can't be read. Error is set for unknown analyses.
+  static std::optional<size_type> parseHeader(const std::string &Line,
+                                              AnalysisRequest &Request,
+                                              std::string &Error) {
+    std::istringstream Header{Line};
+    std::string Keyword, AnalysesList;
+    long long LinesCount = -1;
+    Header >> Keyword >> Request.Id >> AnalysesList >> LinesCount;
+    if (Keyword != "request" || !Header || LinesCount < 0) {
+      Error = "invalid request: " + Line;
+      return std::nullopt;
+    }
+    if (auto Analyses = parseServerAnalyses(AnalysesList))
+      Request.Analyses = std::move(*Analyses);
+    else
+      Error = "unknown analysis in: " + AnalysesList;
+    return LinesCount;
+  }
+
+  void writeAnalysis(std::ostream &Os, const CfgAnalyses &Analyses,
+                     ServerAnalysis Analysis) const {
+    const auto &Graph = Analyses.getGraph();
+    switch (Analysis) {
+    case ServerAnalysis::IDom: {
+      const auto &IDom = Analyses.getIDoms();
+      for (NodeId Id = 0; Id < Graph.size(); ++Id)
+        Os << Graph.getName(Id) << ' '
+           << (IDom[Id] == InvalidNodeId ? "-" : Graph.getName(IDom[Id]))
+           << '\n';
+      break;
+    }
+    case ServerAnalysis::DomFrontier:
+      for (NodeId Id = 0; Id < Graph.size(); ++Id) {
+        Os << Graph.getName(Id) << ':';
+        for (auto Join : Analyses.getFrontiers().getFrontier(Id))
+          Os << ' ' << Graph.getName(Join);
+        Os << '\n';
+      }
+      break;
+    case ServerAnalysis::CfgDot:
+      Analyses.dumpCfg(Os, Style);
+      break;
+    case ServerAnalysis::DomTreeDot:
+      Analyses.dumpDomTree(Os, Style);
+      break;
+    case ServerAnalysis::JoinGraphDot:
+      Analyses.dumpJoinGraph(Os, Style);
+      break;
+    case ServerAnalysis::DomFrontierDot:
+      Analyses.dumpDomFrontier(Os, Style);
+      break;
+    }
+  }
+
+  DomAlgo Algo;
+  DotStyle Style;
+  mutable std::atomic<size_type> HandledCount = 0;
+  std::atomic<int> ListenFd = -1;
+  ThreadPool Pool;
+};
+
+/*
+ * A connection to a socket server. Several requests can be sent before
+ * their responses are received, responses come in the order the server
+ * finishes them.
+ */
+class AnalysisClient final {
+public:
+  explicit AnalysisClient(const fs::path &SocketPath)
+      : Fd(::socket(AF_UNIX, SOCK_STREAM, 0)), Reader(Fd) {
+    auto Addr = detail::makeSocketAddress(SocketPath);
+    if (Fd < 0 ||
+        ::connect(Fd, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) < 0) {
+      if (Fd >= 0)
+        ::close(Fd);
+      throw std::runtime_error("can't connect to socket: " +
+                               SocketPath.string());
+    }
+  }
+
+  AnalysisClient(const AnalysisClient &) = delete;
+  AnalysisClient &operator=(const AnalysisClient &) = delete;
+
+  ~AnalysisClient() { ::close(Fd); }
+
+  // Edges are "From --> To" lines, Analyses is a list like "idom,df"
+  bool send(std::string_view Id, std::string_view Analyses,
+            std::string_view Edges) {
+    auto Frame = utils::formatPrint("request {} {} {}\n", Id, Analyses,
+                                    detail::countLines(Edges));
+    Frame.append(Edges);
+    if (!Edges.empty() && Edges.back() != '\n')
+      Frame.push_back('\n');
+    return detail::writeAll(Fd, Frame);
+  }
+
+  // std::nullopt once the server has closed the connection
+  std::optional<AnalysisResponse> receive() {
+    std::string Line;
+    if (!Reader.readLine(Line))
+      return std::nullopt;
+
+    std::istringstream Header{Line};
+    std::string Keyword, Status;
+    AnalysisResponse Response;
+    Header >> Keyword >> Response.Id >> Status;
+    if (Keyword != "response")
+      return std::nullopt;
+    Response.Ok = Status == "ok";
+    if (!Response.Ok) {
+      std::getline(Header >> std::ws, Response.Body);
+      return Response;
+    }
+    std::size_t LinesCount = 0;
+    if (!(Header >> LinesCount) ||
+        !Reader.readLines(LinesCount, Response.Body))
+      return std::nullopt;
+    return Response;
+  }
+
+  AnalysisResponse request(std::string_view Id, std::string_view Analyses,
+                           std::string_view Edges) {
+    std::optional<AnalysisResponse> Response;
+    if (!send(Id, Analyses, Edges) || !(Response = receive()))
+      throw std::runtime_error("connection closed by the server");
+    return std::move(*Response);
+  }
+
+  // Asks a socket server to stop accepting new connections
+  bool sendShutdown() { return detail::writeAll(Fd, "shutdown\n"); }
+
+private:
+  int Fd;
+  detail::FdLineReader Reader;
+};
+
+} // namespace graphs
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "dominance_analysis.hpp"
+#include "dominators.hpp"
+#include "edge_list_parser.hpp"
+
+namespace graphs {
+
+/*
+ * Binary graph container (.dfbin). All integers are in host byte order,
+ * every section starts at an 8-byte aligned offset from the file start:
+ *
+ *   BinaryGraphHeader
+ *   name offsets    uint64[NodesCount + 1]
+ *   name chars      char[NameBytes]
+ *   succ offsets    uint32[NodesCount + 1], succ targets uint32[EdgesCount]
+ *   pred offsets    uint32[NodesCount + 1], pred targets uint32[EdgesCount]
+ *   idom            uint32[NodesCount]                     (HasIDom)
+ *   DF offsets      uint32[NodesCount + 1], DF targets     (HasFrontiers)
+ *
+ * A mapped file is used in place by BinaryGraphView, nothing is decoded.
+ */
+struct BinaryGraphHeader final {
+  static constexpr std::array<char, 8> DefMagic = {'D', 'F', 'B', 'I',
+                                                   'N', '\0', '\0', '\0'};
+  static constexpr std::uint32_t CurrentVersion = 1;
+  static constexpr std::uint32_t ByteOrderMark = 0x01020304;
+
+  enum Flags : std::uint32_t { HasIDom = 1, HasFrontiers = 2 };
+
+  std::array<char, 8> Magic = DefMagic;
+  std::uint32_t Version = CurrentVersion;
+  std::uint32_t ByteOrder = ByteOrderMark;
+  std::uint32_t Flags = 0;
+  std::uint32_t Reserved = 0;
+  std::uint64_t NodesCount = 0;
+  std::uint64_t EdgesCount = 0;
+  std::uint64_t NameBytes = 0;
+  std::uint64_t FrontiersCount = 0;
+  std::uint64_t NameOffsetsPos = 0;
+  std::uint64_t NameCharsPos = 0;
+  std::uint64_t SuccOffsetsPos = 0;
+  std::uint64_t SuccTargetsPos = 0;
+  std::uint64_t PredOffsetsPos = 0;
+  std::uint64_t PredTargetsPos = 0;
+  std::uint64_t IDomPos = 0;
+  std::uint64_t FrontOffsetsPos = 0;
+  std::uint64_t FrontTargetsPos = 0;
+};
+
+static_assert(sizeof(BinaryGraphHeader) % 8 == 0);
+
+inline constexpr std::string_view BinaryGraphExtension = ".dfbin";
+
+namespace detail {
+
+class BinaryWriter final {
+public:
+  explicit BinaryWriter(std::ostream &Os) : Os(Os) {}
+
+  template <typename T> std::uint64_t write(std::span<const T> Data) {
+    align();
+    auto Pos = Written;
+    Os.write(reinterpret_cast<const char *>(Data.data()), Data.size_bytes());
+    Written += Data.size_bytes();
+    return Pos;
+  }
+
+  void skip(std::size_t Bytes) {
+    std::vector<char> Zeros(Bytes, 0);
+    write(std::span<const char>(Zeros));
+  }
+
+private:
+  void align() {
+    static constexpr char Pad[8] = {};
+    if (auto Rest = Written % 8) {
+      Os.write(Pad, 8 - Rest);
+      Written += 8 - Rest;
+    }
+  }
+
+private:
+  std::ostream &Os;
+  std::uint64_t Written = 0;
+};
+
+} // namespace detail
+
+/*
+ * Writes the graph and, when given, the immediate dominators and dominance
+ * frontiers. The header is written first as a placeholder and rewritten
+ * once the section positions are known, so Os must be seekable.
+ */
+inline void writeBinaryGraph(std::ostream &Os, const CSRGraph &Gr,
+                             const IDomArray *IDom = nullptr,
+                             const FrontierTable *DomFront = nullptr) {
+  BinaryGraphHeader Header;
+  Header.NodesCount = Gr.size();
+  Header.EdgesCount = Gr.getEdgesCount();
+
+  auto HeaderPos = Os.tellp();
+  detail::BinaryWriter Writer(Os);
+  Writer.skip(sizeof(Header));
+
+  std::vector<std::uint64_t> NameOffsets{0};
+  std::string NameChars;
+  for (auto Name : Gr.getNames().getNames()) {
+    NameChars.append(Name);
+    NameOffsets.push_back(NameChars.size());
+  }
+  Header.NameBytes = NameChars.size();
+  Header.NameOffsetsPos =
+      Writer.write(std::span<const std::uint64_t>(NameOffsets));
+  Header.NameCharsPos = Writer.write(std::span<const char>(NameChars));
+
+  Header.SuccOffsetsPos =
+      Writer.write(std::span<const std::uint32_t>(Gr.getSuccOffsets()));
+  Header.SuccTargetsPos =
+      Writer.write(std::span<const NodeId>(Gr.getSuccTargets()));
+  Header.PredOffsetsPos =
+      Writer.write(std::span<const std::uint32_t>(Gr.getPredOffsets()));
+  Header.PredTargetsPos =
+      Writer.write(std::span<const NodeId>(Gr.getPredTargets()));
+
+  if (IDom) {
+    Header.Flags |= BinaryGraphHeader::HasIDom;
+    Header.IDomPos = Writer.write(std::span<const NodeId>(*IDom));
+  }
+
+  if (DomFront) {
+    Header.Flags |= BinaryGraphHeader::HasFrontiers;
+    Header.FrontiersCount = DomFront->getEntriesCount();
+    Header.FrontOffsetsPos =
+        Writer.write(std::span<const std::uint32_t>(DomFront->getOffsets()));
+    Header.FrontTargetsPos =
+        Writer.write(std::span<const NodeId>(DomFront->getTargets()));
+  }
+
+  auto EndPos = Os.tellp();
+  Os.seekp(HeaderPos);
+  Os.write(reinterpret_cast<const char *>(&Header), sizeof(Header));
+  Os.seekp(EndPos);
+}
+
+inline void writeBinaryGraph(const fs::path &Path, const CSRGraph &Gr,
+                             const IDomArray *IDom = nullptr,
+                             const FrontierTable *DomFront = nullptr) {
+  std::ofstream Os{Path, std::ios::binary};
+  if (!Os)
+    throw std::runtime_error("can't create file: " + Path.string());
+  writeBinaryGraph(Os, Gr, IDom, DomFront);
+}
+
+// Read-only graph over a mapped .dfbin file, models IndexedGraph
+class BinaryGraphView final {
+public:
+  using size_type = std::size_t;
+
+  explicit BinaryGraphView(const fs::path &Path) : File(Path) {
+    auto Contents = File.getContents();
+    if (Contents.size() < sizeof(BinaryGraphHeader))
+      throw std::runtime_error("truncated graph file: " + Path.string());
+
+    Header = reinterpret_cast<const BinaryGraphHeader *>(Contents.data());
+    if (Header->Magic != BinaryGraphHeader::DefMagic)
+      throw std::runtime_error("not a binary graph file: " + Path.string());
+    if (Header->ByteOrder != BinaryGraphHeader::ByteOrderMark)
+      throw std::runtime_error("foreign byte order: " + Path.string());
+    if (Header->Version != BinaryGraphHeader::CurrentVersion)
+      throw std::runtime_error("unsupported graph file version: " +
+                               Path.string());
+
+    auto Nodes = Header->NodesCount, Edges = Header->EdgesCount;
+    if (Nodes >= InvalidNodeId)
+      throw std::runtime_error("corrupted graph file: too many nodes: " +
+                               Path.string());
+    NameOffsets = getSection<std::uint64_t>(Header->NameOffsetsPos, Nodes + 1);
+    NameChars = getSection<char>(Header->NameCharsPos, Header->NameBytes);
+    SuccOffsets = getSection<std::uint32_t>(Header->SuccOffsetsPos, Nodes + 1);
+    SuccTargets = getSection<NodeId>(Header->SuccTargetsPos, Edges);
+    PredOffsets = getSection<std::uint32_t>(Header->PredOffsetsPos, Nodes + 1);
+    PredTargets = getSection<NodeId>(Header->PredTargetsPos, Edges);
+    if (Header->Flags & BinaryGraphHeader::HasIDom)
+      IDom = getSection<NodeId>(Header->IDomPos, Nodes);
+    if (Header->Flags & BinaryGraphHeader::HasFrontiers) {
+      FrontOffsets =
+          getSection<std::uint32_t>(Header->FrontOffsetsPos, Nodes + 1);
+      FrontTargets = getSection<NodeId>(Header->FrontTargetsPos,
+                                        Header->FrontiersCount);
+    }
+
+    // the sections are used as they are, so every offset and id is checked
+    // once here
+    auto IsNodeId = [Nodes](NodeId Id) { return Id < Nodes; };
+    if (!isValidOffsets(NameOffsets, Header->NameBytes) ||
+        !isValidOffsets(SuccOffsets, Edges) ||
+        !isValidOffsets(PredOffsets, Edges) ||
+        !std::ranges::all_of(SuccTargets, IsNodeId) ||
+        !std::ranges::all_of(PredTargets, IsNodeId) ||
+        !std::ranges::all_of(IDom,
+                             [&](NodeId Id) {
+                               return Id == InvalidNodeId || IsNodeId(Id);
+                             }) ||
+        (hasFrontiers() &&
+         (!isValidOffsets(FrontOffsets, Header->FrontiersCount) ||
+          !std::ranges::all_of(FrontTargets, IsNodeId))))
+      throw std::runtime_error("corrupted graph file: " + Path.string());
+  }
+
+  // IndexedGraph interface
+  size_type size() const noexcept { return Header->NodesCount; }
+
+  std::span<const NodeId> getSuccessors(NodeId Id) const noexcept {
+    return SuccTargets.subspan(SuccOffsets[Id],
+                               SuccOffsets[Id + 1] - SuccOffsets[Id]);
+  }
+  std::span<const NodeId> getPredecessors(NodeId Id) const noexcept {
+    return PredTargets.subspan(PredOffsets[Id],
+                               PredOffsets[Id + 1] - PredOffsets[Id]);
+  }
+
+  size_type getEdgesCount() const noexcept { return Header->EdgesCount; }
+
+  std::string_view getName(NodeId Id) const noexcept {
+    return {NameChars.data() + NameOffsets[Id],
+            NameOffsets[Id + 1] - NameOffsets[Id]};
+  }
+
+  bool hasIDom() const noexcept {
+    return Header->Flags & BinaryGraphHeader::HasIDom;
+  }
+  std::span<const NodeId> getIDom() const noexcept { return IDom; }
+
+  bool hasFrontiers() const noexcept {
+    return Header->Flags & BinaryGraphHeader::HasFrontiers;
+  }
+  std::span<const NodeId> getFrontier(NodeId Id) const noexcept {
+    return FrontTargets.subspan(FrontOffsets[Id],
+                                FrontOffsets[Id + 1] - FrontOffsets[Id]);
+  }
+
+  // The stored idom and frontiers, if the file has both
+  std::optional<DominanceResult> getDominanceResult() const {
+    if (!hasIDom() || !hasFrontiers())
+      return std::nullopt;
+    return DominanceResult{
+        IDomArray(IDom.begin(), IDom.end()),
+        FrontierTable({FrontOffsets.begin(), FrontOffsets.end()},
+                      {FrontTargets.begin(), FrontTargets.end()})};
+  }
+
+  // CFG edges in successor order, with owned names
+  std::vector<EdgeType> getEdges() const {
+    std::vector<EdgeType> Edges;
+    Edges.reserve(getEdgesCount());
+    for (NodeId From = 0; From < size(); ++From)
+      for (auto To : getSuccessors(From))
+        Edges.emplace_back(getName(From), getName(To));
+    return Edges;
+  }
+
+private:
+  // Rows start at 0, never go back and end at Last
+  template <typename T>
+  static bool isValidOffsets(std::span<const T> Offsets,
+                             std::uint64_t Last) noexcept {
+    return Offsets.front() == 0 && Offsets.back() == Last &&
+           std::ranges::is_sorted(Offsets);
+  }
+
+  template <typename T>
+  std::span<const T> getSection(std::uint64_t Pos, std::uint64_t Count) const {
+    auto Contents = File.getContents();
+    if (Pos % alignof(T) || Pos > Contents.size() ||
+        Count > (Contents.size() - Pos) / sizeof(T))
+      throw std::runtime_error("corrupted graph file section");
+    return {reinterpret_cast<const T *>(Contents.data() + Pos), Count};
+  }
+
+private:
+  MappedFile File;
+  const BinaryGraphHeader *Header = nullptr;
+  std::span<const std::uint64_t> NameOffsets;
+  std::span<const char> NameChars;
+  std::span<const std::uint32_t> SuccOffsets;
+  std::span<const NodeId> SuccTargets;
+  std::span<const std::uint32_t> PredOffsets;
+  std::span<const NodeId> PredTargets;
+  std::span<const NodeId> IDom;
+  std::span<const std::uint32_t> FrontOffsets;
+  std::span<const NodeId> FrontTargets;
+};
+
+} // namespace graphs
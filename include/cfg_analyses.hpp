@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "dominance_analysis.hpp"
+#include "dot_writer.hpp"
+#include "statistics.hpp"
+
+namespace graphs {
+
+/*
+ * The dominator tree, the DJ-graph and the dominance frontiers of one CFG,
+ * all derived from a single dominator computation. The DOT dumps are the
+ * same as the ones of DirectedGraph, DomTreeGraph, DomJoinGraph and
+ * DomFrontierGraph built from the same edges. GraphT is a NamedIndexedGraph
+ * owned by the analyses, e.g. a CSRGraph or a BinaryGraphView.
+ */
+template <NamedIndexedGraph GraphT> class BasicCfgAnalyses final {
+public:
+  using size_type = std::size_t;
+
+  BasicCfgAnalyses(GraphT Graph, DomAlgo Algo, size_type ThreadsCount = 1)
+      : Graph(std::move(Graph)),
+        IDom(computeIDom(this->Graph, Algo, 0, &DomIterations)),
+        Tree(detail::buildDomTreeChildren(IDom)),
+        Frontiers(computeFrontierTable(this->Graph, IDom, ThreadsCount)),
+        JoinEdges(collectJoinEdges(ThreadsCount)) {}
+
+  // Dominators and frontiers computed before, e.g. loaded from a ResultCache
+  BasicCfgAnalyses(GraphT Graph, IDomArray IDom, FrontierTable Frontiers,
+                   size_type ThreadsCount = 1)
+      : Graph(std::move(Graph)), IDom(std::move(IDom)),
+        Frontiers(std::move(Frontiers)) {
+    if (this->IDom.size() != this->Graph.size() ||
+        this->Frontiers.size() != this->Graph.size())
+      throw std::runtime_error("dominators don't match the graph");
+    Tree = detail::buildDomTreeChildren(this->IDom);
+    JoinEdges = collectJoinEdges(ThreadsCount);
+  }
+
+  const GraphT &getGraph() const noexcept { return Graph; }
+  const IDomArray &getIDoms() const noexcept { return IDom; }
+  const FrontierTable &getFrontiers() const noexcept { return Frontiers; }
+  std::span<const IdEdgeType> getJoinEdges() const noexcept {
+    return JoinEdges;
+  }
+
+  // fixpoint passes made by an iterative engine, 0 for the others
+  size_type getDomIterations() const noexcept { return DomIterations; }
+
+  void dumpCfg(std::ostream &Os, const DotStyle &Style,
+               size_type ThreadsCount = 1) const {
+    DotWriter Writer(Os, ThreadsCount);
+    Writer.writeHeader(Style);
+    writeRows(Writer, [this](NodeId Id) { return Graph.getSuccessors(Id); });
+    Writer << "}\n";
+  }
+
+  void dumpDomTree(std::ostream &Os, const DotStyle &Style,
+                   size_type ThreadsCount = 1) const {
+    DotWriter Writer(Os, ThreadsCount);
+    Writer.writeHeader(Style);
+    writeRows(Writer, [this](NodeId Id) { return getChildren(Id); });
+    Writer << "}\n";
+  }
+
+  void dumpJoinGraph(std::ostream &Os, const DotStyle &Style,
+                     size_type ThreadsCount = 1) const {
+    DotWriter Writer(Os, ThreadsCount);
+    Writer.writeHeader(Style);
+    writeRows(Writer, [this](NodeId Id) { return getChildren(Id); });
+    Writer.writeRange(JoinEdges.size(), [this](size_type Idx,
+                                               std::string &Out) {
+      auto [From, To] = JoinEdges[Idx];
+      DotWriter::appendEdge(Out, Graph.getName(From), Graph.getName(To),
+                            "style = dotted");
+    });
+    Writer << "}\n";
+  }
+
+  // Nodes having an empty frontier are listed alone
+  void dumpDomFrontier(std::ostream &Os, const DotStyle &Style,
+                       size_type ThreadsCount = 1) const {
+    DotWriter Writer(Os, ThreadsCount);
+    Writer.writeHeader(Style);
+    writeRows(Writer, [this](NodeId Id) { return Frontiers.getFrontier(Id); });
+    for (NodeId Id = 0; Id < Graph.size(); ++Id)
+      if (Frontiers.getFrontier(Id).empty())
+        Writer.writeNode(Graph.getName(Id));
+    Writer << "}\n";
+  }
+
+private:
+  std::span<const NodeId> getChildren(NodeId Id) const noexcept {
+    return std::span(Tree.Children)
+        .subspan(Tree.Offsets[Id], Tree.Offsets[Id + 1] - Tree.Offsets[Id]);
+  }
+
+  // "Id -> Target" for every node and every target of its row
+  template <typename RowFunc>
+  void writeRows(DotWriter &Writer, RowFunc GetRow) const {
+    Writer.writeRange(Graph.size(), [&](size_type Id, std::string &Out) {
+      auto Name = Graph.getName(Id);
+      for (NodeId Target : GetRow(Id))
+        DotWriter::appendEdge(Out, Name, Graph.getName(Target));
+    });
+  }
+
+  // CFG edges but the tree ones, edges of unreachable nodes included, each
+  // edge once and sorted by names, as DomJoinGraph keeps them
+  std::vector<IdEdgeType> collectJoinEdges(size_type ThreadsCount) const {
+    auto Edges = findJoinEdges(Graph, IDom, ThreadsCount);
+    detail::sortEdgesByNames(Edges, Graph.size(), [this](NodeId Id) {
+      return Graph.getName(Id);
+    });
+    return Edges;
+  }
+
+  GraphT Graph;
+  size_type DomIterations = 0;
+  IDomArray IDom;
+  detail::DomTreeChildren Tree;
+  FrontierTable Frontiers;
+  std::vector<IdEdgeType> JoinEdges;
+};
+
+using CfgAnalyses = BasicCfgAnalyses<CSRGraph>;
+
+} // namespace graphs
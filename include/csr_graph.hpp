@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "directed_graph.hpp"
+#include "dominators.hpp"
+#include "name_table.hpp"
+
+namespace graphs {
+
+using EdgeIdType = std::pair<NodeId, NodeId>;
+
+// Compressed sparse row graph: successors of node n are
+// SuccTargets[SuccOffsets[n] .. SuccOffsets[n + 1]), the same for
+// predecessors. Node 0 is the entry node, names live in a NameTable.
+class CSRGraph final {
+public:
+  using size_type = std::size_t;
+  using OffsetType = std::uint32_t;
+
+  CSRGraph() = default;
+
+  // Names must already hold every node referenced by Edges
+  CSRGraph(NameTable Names, std::span<const EdgeIdType> Edges)
+      : Names(std::move(Names)) {
+    auto Size = this->Names.size();
+    fillRows(Size, Edges, &EdgeIdType::first, &EdgeIdType::second,
+             SuccOffsets, SuccTargets);
+    fillRows(Size, Edges, &EdgeIdType::second, &EdgeIdType::first,
+             PredOffsets, PredTargets);
+  }
+
+  template <InputEdgeIter InputIt>
+  CSRGraph(InputIt BeginIt, InputIt EndIt)
+      : CSRGraph(internEdges(BeginIt, EndIt)) {}
+
+  // IndexedGraph interface
+  size_type size() const noexcept { return Names.size(); }
+
+  std::span<const NodeId> getSuccessors(NodeId Id) const noexcept {
+    return getRow(SuccOffsets, SuccTargets, Id);
+  }
+  std::span<const NodeId> getPredecessors(NodeId Id) const noexcept {
+    return getRow(PredOffsets, PredTargets, Id);
+  }
+
+  size_type getEdgesCount() const noexcept { return SuccTargets.size(); }
+
+  std::string_view getName(NodeId Id) const { return Names.getName(Id); }
+  const NameTable &getNames() const noexcept { return Names; }
+
+  const std::vector<OffsetType> &getSuccOffsets() const noexcept {
+    return SuccOffsets;
+  }
+  const std::vector<NodeId> &getSuccTargets() const noexcept {
+    return SuccTargets;
+  }
+  const std::vector<OffsetType> &getPredOffsets() const noexcept {
+    return PredOffsets;
+  }
+  const std::vector<NodeId> &getPredTargets() const noexcept {
+    return PredTargets;
+  }
+
+private:
+  template <typename InputIt>
+  static std::pair<NameTable, std::vector<EdgeIdType>>
+  internEdges(InputIt BeginIt, InputIt EndIt) {
+    NameTable Names;
+    std::vector<EdgeIdType> Edges;
+    for (; BeginIt != EndIt; ++BeginIt) {
+      const auto &Edge = *BeginIt;
+      auto From = Names.intern(Edge.first);
+      Edges.emplace_back(From, Names.intern(Edge.second));
+    }
+    return {std::move(Names), std::move(Edges)};
+  }
+
+  explicit CSRGraph(std::pair<NameTable, std::vector<EdgeIdType>> Interned)
+      : CSRGraph(std::move(Interned.first), Interned.second) {}
+
+  // Counting sort of the edges by the Key end, keeps the input order
+  // inside each row
+  static void fillRows(size_type Size, std::span<const EdgeIdType> Edges,
+                       NodeId EdgeIdType::*Key, NodeId EdgeIdType::*Value,
+                       std::vector<OffsetType> &Offsets,
+                       std::vector<NodeId> &Targets) {
+    Offsets.assign(Size + 1, 0);
+    for (const auto &Edge : Edges)
+      ++Offsets[Edge.*Key + 1];
+    for (size_type Id = 0; Id < Size; ++Id)
+      Offsets[Id + 1] += Offsets[Id];
+
+    Targets.resize(Edges.size());
+    std::vector<OffsetType> Cursor(Offsets.begin(), std::prev(Offsets.end()));
+    for (const auto &Edge : Edges)
+      Targets[Cursor[Edge.*Key]++] = Edge.*Value;
+  }
+
+  static std::span<const NodeId> getRow(const std::vector<OffsetType> &Offsets,
+                                        const std::vector<NodeId> &Targets,
+                                        NodeId Id) noexcept {
+    return {Targets.data() + Offsets[Id], Targets.data() + Offsets[Id + 1]};
+  }
+
+private:
+  NameTable Names;
+  std::vector<OffsetType> SuccOffsets;
+  std::vector<NodeId> SuccTargets;
+  std::vector<OffsetType> PredOffsets;
+  std::vector<NodeId> PredTargets;
+};
+
+} // namespace graphs
@@ -8,20 +8,34 @@
 #include <iterator>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <queue>
 #include <ranges>
 #include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "dominance_analysis.hpp"
+#include "dominator_bitsets.hpp"
+#include "dominators.hpp"
+#include "dot_writer.hpp"
+#include "name_table.hpp"
+#include "statistics.hpp"
 #include "utils.hpp"
 
 namespace graphs {
 
 namespace rgs = std::ranges;
 
+// Nodes, adjacency lists and analysis tables of a graph come from one
+// memory resource, e.g. an arena released at once with the whole analysis
+using GraphAllocator = std::pmr::polymorphic_allocator<std::byte>;
+
 template <typename T>
   requires std::is_default_constructible_v<T>
 class DirectedGraph;
@@ -33,17 +47,21 @@ class DirGraphNode {
 public:
   using size_type = std::size_t;
   using NodePtr = DirGraphNode*;
+  using allocator_type = GraphAllocator;
 
-  DirGraphNode(Data Dat, const std::string &Name = "",
-               DirGraphPtr Parent = nullptr)
-      : Dat(Dat), Name(Name), Parent(Parent) {}
+  // Name is a view, e.g. of the name table of the parent graph
+  DirGraphNode(Data Dat, std::string_view Name = {},
+               DirGraphPtr Parent = nullptr, NodeId Id = 0,
+               const allocator_type &Alloc = {})
+      : Dat(Dat), Name(Name), Parent(Parent), Id(Id), Successors(Alloc),
+        Predecessors(Alloc) {}
 
   virtual ~DirGraphNode() {}
 
   const Data &getData() const noexcept { return Dat; }
   Data &getData() noexcept { return Dat; }
   
-  std::string getName() const { return Name; }
+  std::string_view getName() const noexcept { return Name; }
 
   void addSuccessor(NodePtr Ptr) {
     Successors.push_back(Ptr);
@@ -57,9 +75,13 @@ public:
     }
   }
   void addPredecessor(NodePtr Ptr) { Predecessors.push_back(Ptr); }
+  // unlike addSuccessor, the predecessors of Ptr are left as they are
+  void appendSuccessor(NodePtr Ptr) { Successors.push_back(Ptr); }
   void removePredecessor(NodePtr Ptr) { std::erase(Predecessors, Ptr); }
 
   DirGraphPtr getParent() const noexcept { return Parent; }
+  // position of the node in the parent graph
+  NodeId getId() const noexcept { return Id; }
 
   auto getSuccessors() const { return rgs::subrange{Successors}; }
   auto getPredecessors() const { return rgs::subrange{Predecessors}; }
@@ -92,30 +114,57 @@ public:
 
 private:
   Data Dat;
-  std::string Name;
+  std::string_view Name;
   DirGraphPtr Parent;
-  std::vector<NodePtr> Successors;
-  std::vector<NodePtr> Predecessors;
+  NodeId Id;
+  std::pmr::vector<NodePtr> Successors;
+  std::pmr::vector<NodePtr> Predecessors;
 };
 
 using EdgeType = std::pair<std::string, std::string>;
 
+// Edges are pairs of node names: owned ones (EdgeType) or views into a text
 template <typename T>
 concept InputEdgeIter = std::input_iterator<T> && requires(T It) {
-  { *It } -> std::convertible_to<EdgeType>;
+  { (*It).first } -> std::convertible_to<std::string_view>;
+  { (*It).second } -> std::convertible_to<std::string_view>;
 };
 
+// A range of edges, e.g. an EdgeListView over a mapped text
+template <typename T>
+concept EdgeRange =
+    rgs::input_range<const T> && InputEdgeIter<rgs::iterator_t<const T>>;
+
+// An IndexedGraph with node names, e.g. a CSRGraph or a BinaryGraphView
+template <typename T>
+concept NamedIndexedGraph =
+    IndexedGraph<T> && requires(const T &Gr, NodeId Id) {
+      { Gr.getName(Id) } -> std::convertible_to<std::string_view>;
+    };
+
+// What a graph can be built from
+template <typename T>
+concept CfgSource = EdgeRange<T> || NamedIndexedGraph<T>;
+
 template <typename T>
   requires std::is_default_constructible_v<T>
 class DirectedGraph {
 protected:
   using NodeType = DirGraphNode<T>;
   using NodeTypePtr = NodeType *;
-  using StoredNodePtr = std::unique_ptr<NodeType>;
+
+  // Gives a node back to the allocator it was created by
+  struct NodeDeleter final {
+    void operator()(NodeType *Ptr) { Alloc.delete_object(Ptr); }
+
+    GraphAllocator Alloc;
+  };
+  using StoredNodePtr = std::unique_ptr<NodeType, NodeDeleter>;
 
 public:
   using value_type = T;
-  using DomTable = std::map<NodeTypePtr, std::set<NodeTypePtr>>;
+  using allocator_type = GraphAllocator;
+  using DomTable = std::pmr::map<NodeTypePtr, std::pmr::set<NodeTypePtr>>;
   using DGT = DirectedGraph<value_type>;
 
   static constexpr std::string_view DefGraphName = "CFG";
@@ -125,18 +174,21 @@ public:
   static constexpr std::string_view DefEdgeShape = "vee";
 public:
   template <InputEdgeIter InputIt>
-  DirectedGraph(InputIt BeginIt, InputIt EndIt) {
-    std::unordered_map<std::string, NodeType *> Vertices;
-
-    for (; BeginIt != EndIt; ++BeginIt) {
-      for (auto &V : {BeginIt->first, BeginIt->second}) {
-        if (!Vertices.contains(V)) {
-          Nodes.push_back(std::make_unique<NodeType>(value_type(), V, this));
-          Vertices.emplace(std::move(V), Nodes.back().get());
-        }
-      }
-      Vertices[BeginIt->first]->addSuccessor(Vertices[BeginIt->second]);
-    }
+  DirectedGraph(InputIt BeginIt, InputIt EndIt,
+                const allocator_type &Alloc = {})
+      : DirectedGraph(rgs::subrange(BeginIt, EndIt), Alloc) {}
+
+  // Names of the edges are interned as they come, an EdgeListView is
+  // parsed right into the graph. A NamedIndexedGraph keeps its node ids
+  // and the order of both adjacency lists.
+  template <CfgSource Source>
+  explicit DirectedGraph(const Source &Cfg, const allocator_type &Alloc = {})
+      : Names(Alloc), Nodes(Alloc) {
+    GRAPHS_STATS_PHASE("graph");
+    if constexpr (NamedIndexedGraph<Source>)
+      copyGraph(Cfg);
+    else
+      readEdges(Cfg);
   }
 
   virtual ~DirectedGraph() {}
@@ -147,85 +199,160 @@ public:
                   std::string_view NodeShape = DefNodeShape,
                   std::string_view NodeColor = DefNodeColor,
                   std::string_view EdgeShape = DefEdgeShape,
-                  std::string_view EdgeColor = DefEdgeColor) const {
-    dumpInDotFormatBaseImpl(DotDump, GraphName, NodeShape, NodeColor, EdgeShape,
+                  std::string_view EdgeColor = DefEdgeColor,
+                  std::size_t ThreadsCount = 1) const {
+    DotWriter Writer(DotDump, ThreadsCount);
+    dumpInDotFormatBaseImpl(Writer, GraphName, NodeShape, NodeColor, EdgeShape,
                             EdgeColor);
-    DotDump << "}\n";
+    Writer << "}\n";
   }
 
+  allocator_type getAllocator() const noexcept { return Nodes.get_allocator(); }
+
   // access random graph node ptr
   NodeTypePtr getNodePtr() const noexcept { return Nodes.front().get(); }
 
-  /*
-   * Dom(n) = n \/ ( /\ Dom(m)), where m is a set of predecessors of the n
-   */
+  // IndexedGraph interface: node ids are positions in Nodes
+  std::size_t size() const noexcept { return Nodes.size(); }
+  NodeTypePtr getNode(NodeId Id) const noexcept { return Nodes[Id].get(); }
+
+  // InvalidNodeId if there is no node with the name
+  NodeId findNodeId(std::string_view Name) const { return Names.find(Name); }
+
+  auto getSuccessors(NodeId Id) const {
+    return Nodes[Id]->getSuccessors() | std::views::transform(getIdOf);
+  }
+
+  auto getPredecessors(NodeId Id) const {
+    return Nodes[Id]->getPredecessors() | std::views::transform(getIdOf);
+  }
+
+  // The root (Nodes.front()) is its own immediate dominator.
+  // Iterations is set only by the Cooper-Harvey-Kennedy engine.
+  IDomArray determineImmediateDominators(
+      DomAlgo Algo, std::size_t *Iterations = nullptr) const {
+    return computeIDom(*this, Algo, 0, Iterations);
+  }
+
+  // Full dominator sets. The fast engines produce them on demand from the
+  // immediate dominators: Dom(n) = n + Dom(idom(n))
+  DomTable determineDominators(DomAlgo Algo) const {
+    if (Algo == DomAlgo::Iterative)
+      return determineDominators();
+
+    auto IDom = determineImmediateDominators(Algo);
+    DomTable DomTbl(getAllocator());
+    for (const auto &UniquePtr : Nodes) {
+      auto &DomSet = DomTbl[UniquePtr.get()];
+      auto Id = UniquePtr->getId();
+      // unreachable nodes are dominated by every node
+      if (IDom[Id] == InvalidNodeId) {
+        rgs::transform(Nodes, std::inserter(DomSet, DomSet.end()),
+                       [](auto &Ptr) { return Ptr.get(); });
+        continue;
+      }
+      for (DomSet.insert(Nodes[Id].get()); IDom[Id] != Id; Id = IDom[Id])
+        DomSet.insert(Nodes[IDom[Id]].get());
+    }
+
+    return DomTbl;
+  }
+
+  // Dominator sets as rows of a bit matrix indexed by node ids
+  DomBitMatrix determineDominatorBits() const {
+    return computeDominatorBits(*this);
+  }
+
   DomTable determineDominators() const {
     if (Nodes.empty())
       return {};
 
-    DomTable DomTbl;
-    std::set<NodeTypePtr> Set;
-    rgs::transform(Nodes, std::inserter(Set, Set.end()),
-                   [](auto &UniquePtr) { return UniquePtr.get(); });
-    rgs::transform(Nodes, std::inserter(DomTbl, DomTbl.end()),
-                   [&Set](auto &UniquePtr) {
-                     return std::make_pair(UniquePtr.get(), Set);
-                   });
-
-    auto FrontPtr = Nodes.front().get();
-    DomTbl[FrontPtr].clear();
-    DomTbl[FrontPtr].insert(FrontPtr);
-
-    bool Changed = true;
-    while (Changed) {
-      Changed = false;
-      for (auto &UniquePtr : Nodes) {
-        auto NodePtr = UniquePtr.get();
-        auto TmpSet = DomTbl[NodePtr];
-        for (auto Pred : NodePtr->getPredecessors()) {
-          auto &CompSet = DomTbl[Pred];
-          std::set<NodeTypePtr> SaveComp;
-          rgs::set_intersection(CompSet, TmpSet,
-                                std::inserter(SaveComp, SaveComp.end()));
-          TmpSet = std::move(SaveComp);
-        }
-        TmpSet.insert(NodePtr);
-        Changed |= DomTbl[NodePtr] != TmpSet;
-        if (DomTbl[NodePtr] != TmpSet) {
-          DomTbl[NodePtr] = std::move(TmpSet);
-        }
-      }
+    auto DomBits = determineDominatorBits();
+    DomTable DomTbl(getAllocator());
+    for (const auto &UniquePtr : Nodes) {
+      auto &DomSet = DomTbl[UniquePtr.get()];
+      DomBits.forEach(UniquePtr->getId(), [&](NodeId Id) {
+        DomSet.insert(Nodes[Id].get());
+      });
     }
 
     return DomTbl;
   }
 
 protected:
-  void dumpInDotFormatBaseImpl(std::ofstream &DotDump,
+  void dumpInDotFormatBaseImpl(DotWriter &Writer,
                                std::string_view NodeShape,
                                std::string_view NodeColor,
                                std::string_view EdgeShape,
                                std::string_view EdgeColor,
                                std::string_view GraphName) const {
 
-    DotDump << utils::formatPrint(
-        "digraph {} {}\n"
-        "\tlabel=\"{}\"\n"
-        "\tdpi = 100;\n"
-        "\tfontname = \"Comic Sans MS\";\n"
-        "\tfontsize = 20;\n"
-        "\trankdir  = TB;\n"
-        "node [shape = {}, style = filled, fillcolor = \"{}\"];\n"
-        "edge [color = {}, arrowhead = {}, arrowsize = 1,"
-        "penwidth = 1.2];\n",
-        GraphName, '{', GraphName, NodeShape, NodeColor, EdgeColor, EdgeShape);
-
-    for (const auto &Ptr : Nodes) {
-      auto Name = Ptr.get()->getName();
-      for (auto Vertex : Ptr.get()->getSuccessors()) {
-        DotDump << utils::formatPrint("{} -> {};\n", Name, Vertex->getName());
+    Writer.writeHeader({.GraphName = GraphName,
+                        .NodeShape = NodeShape,
+                        .NodeColor = NodeColor,
+                        .EdgeShape = EdgeShape,
+                        .EdgeColor = EdgeColor});
+
+    Writer.writeRange(Nodes.size(), [this](NodeId Id, std::string &Out) {
+      auto Name = Nodes[Id]->getName();
+      for (auto Vertex : Nodes[Id]->getSuccessors())
+        DotWriter::appendEdge(Out, Name, Vertex->getName());
+    });
+  }
+
+  template <EdgeRange Edges> void readEdges(const Edges &Cfg) {
+    // a name is hashed once per edge end, the node ids are the name ids
+    auto GetNodeId = [this](std::string_view Name) {
+      auto Id = Names.intern(Name);
+      if (Id == Nodes.size())
+        Nodes.push_back(makeNode(Names.getName(Id)));
+      return Id;
+    };
+
+    std::size_t EdgesCount = 0;
+    for (const auto &[FromName, ToName] : Cfg) {
+      auto From = GetNodeId(FromName);
+      Nodes[From]->addSuccessor(Nodes[GetNodeId(ToName)].get());
+      ++EdgesCount;
+    }
+    GRAPHS_STATS_COUNT("graph.nodes", Nodes.size());
+    GRAPHS_STATS_COUNT("graph.edges", EdgesCount);
+  }
+
+  template <NamedIndexedGraph GraphT> void copyGraph(const GraphT &Cfg) {
+    NodeId Size = Cfg.size();
+    Names.reserve(Size);
+    Nodes.reserve(Size);
+    for (NodeId Id = 0; Id < Size; ++Id) {
+      std::string_view Name = Cfg.getName(Id);
+      if (Names.intern(Name) != Id)
+        throw std::runtime_error("duplicate node name: " + std::string(Name));
+      Nodes.push_back(makeNode(Names.getName(Id)));
+    }
+
+    std::size_t EdgesCount = 0;
+    for (NodeId Id = 0; Id < Size; ++Id) {
+      for (NodeId To : Cfg.getSuccessors(Id)) {
+        Nodes[Id]->appendSuccessor(Nodes[To].get());
+        ++EdgesCount;
       }
+      for (NodeId From : Cfg.getPredecessors(Id))
+        Nodes[Id]->addPredecessor(Nodes[From].get());
     }
+    GRAPHS_STATS_COUNT("graph.nodes", Nodes.size());
+    GRAPHS_STATS_COUNT("graph.edges", EdgesCount);
+  }
+
+  // The node gets the next id. Name must be kept by Names, see internName
+  StoredNodePtr makeNode(std::string_view Name) {
+    GraphAllocator Alloc = getAllocator();
+    return StoredNodePtr(
+        Alloc.new_object<NodeType>(value_type(), Name, this, Nodes.size()),
+        NodeDeleter{Alloc});
+  }
+
+  std::string_view internName(std::string_view Name) {
+    return Names.getName(Names.intern(Name));
   }
 
   void clearGraphThreads() {
@@ -233,8 +360,13 @@ protected:
                   [](auto &UniquePtr) { UniquePtr.get()->clearThreads(); });
   }
 
+  static NodeId getIdOf(const NodeType *NodePtr) noexcept {
+    return NodePtr->getId();
+  }
+
 protected:
-  std::vector<StoredNodePtr> Nodes;
+  NameTable Names;
+  std::pmr::vector<StoredNodePtr> Nodes;
 };
 
 template <std::input_iterator InputIt>
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dominator_bitsets.hpp"
+#include "dominators.hpp"
+#include "statistics.hpp"
+
+namespace graphs {
+
+using IdEdgeType = std::pair<NodeId, NodeId>;
+
+namespace detail {
+
+// The root is the only node being its own immediate dominator
+inline NodeId getIDomParent(const IDomArray &IDom, NodeId Id) noexcept {
+  return IDom[Id] == Id ? InvalidNodeId : IDom[Id];
+}
+
+// Dominator tree in CSR form: children of n are
+// Children[Offsets[n] .. Offsets[n + 1]), in increasing id order
+struct DomTreeChildren final {
+  std::vector<std::uint32_t> Offsets;
+  std::vector<NodeId> Children;
+
+  std::span<const NodeId> get(NodeId Id) const noexcept {
+    return std::span(Children).subspan(Offsets[Id],
+                                       Offsets[Id + 1] - Offsets[Id]);
+  }
+};
+
+inline DomTreeChildren buildDomTreeChildren(const IDomArray &IDom) {
+  auto Size = IDom.size();
+  auto IsChild = [&IDom](NodeId Id) {
+    return IDom[Id] != InvalidNodeId && IDom[Id] != Id;
+  };
+
+  DomTreeChildren Tree;
+  Tree.Offsets.assign(Size + 1, 0);
+  for (NodeId Id = 0; Id < Size; ++Id)
+    if (IsChild(Id))
+      ++Tree.Offsets[IDom[Id] + 1];
+  for (std::size_t Id = 0; Id < Size; ++Id)
+    Tree.Offsets[Id + 1] += Tree.Offsets[Id];
+  Tree.Children.resize(Tree.Offsets.back());
+  auto Pos = Tree.Offsets;
+  for (NodeId Id = 0; Id < Size; ++Id)
+    if (IsChild(Id))
+      Tree.Children[Pos[IDom[Id]]++] = Id;
+
+  return Tree;
+}
+
+} // namespace detail
+
+// idom(n) is the strict dominator of n that is dominated by all others,
+// i.e. the one having the largest dominator set
+template <IndexedGraph G>
+IDomArray getIDomFromDomBits(const G &Gr, const DomBitMatrix &DomBits,
+                             NodeId Root = 0) {
+  IDomArray IDom(Gr.size(), InvalidNodeId);
+  if (Gr.size() == 0)
+    return IDom;
+
+  std::vector<std::size_t> DomCount(Gr.size());
+  for (NodeId Id = 0; Id < Gr.size(); ++Id)
+    DomCount[Id] = DomBits.count(Id);
+
+  // unreachable nodes keep the full node set, skip them
+  auto Reachable = detail::buildDFSTree(Gr, Root).Num;
+  for (NodeId Id = 0; Id < Gr.size(); ++Id) {
+    if (!Reachable[Id])
+      continue;
+    IDom[Id] = Id;
+    DomBits.forEach(Id, [&](NodeId Dom) {
+      if (Dom != Id && (IDom[Id] == Id || DomCount[Dom] > DomCount[IDom[Id]]))
+        IDom[Id] = Dom;
+    });
+  }
+
+  return IDom;
+}
+
+// Iterations is set only by the Cooper-Harvey-Kennedy engine
+template <IndexedGraph G>
+IDomArray computeIDom(const G &Gr, DomAlgo Algo, NodeId Root = 0,
+                      std::size_t *Iterations = nullptr) {
+  GRAPHS_STATS_PHASE("dominators");
+  switch (Algo) {
+  case DomAlgo::LengauerTarjan:
+    return computeIDomLengauerTarjan(Gr, Root);
+  case DomAlgo::SemiNCA:
+    return computeIDomSemiNCA(Gr, Root);
+  case DomAlgo::CooperHarveyKennedy:
+    return computeIDomCooperHarveyKennedy(Gr, Root, Iterations);
+  case DomAlgo::Iterative:
+  default:
+    return getIDomFromDomBits(Gr, computeDominatorBits(Gr, Root), Root);
+  }
+}
+
+/*
+ * Join edges of the DJ-graph: CFG edges u -> v which are not dominator
+ * tree edges, i.e. idom(v) != u. A self loop is a join edge even at the
+ * root, and so is every edge leaving an unreachable node. One pass over
+ * the successor lists, no sorting: edges come in the order of their
+ * sources and then of the successor lists, duplicates kept.
+ *
+ * Sources can be split into ThreadsCount ranges, every thread fills its
+ * own buffer and the buffers are joined in range order, so the result is
+ * the same for any ThreadsCount.
+ */
+template <IndexedGraph G, typename Alloc = std::allocator<IdEdgeType>>
+std::vector<IdEdgeType, Alloc> findJoinEdges(const G &Gr,
+                                             const IDomArray &IDom,
+                                             std::size_t ThreadsCount = 1,
+                                             const Alloc &Al = {}) {
+  GRAPHS_STATS_PHASE("join-edges");
+  auto Size = static_cast<NodeId>(Gr.size());
+  auto Collect = [&](NodeId Begin, NodeId End, auto &Edges) {
+    for (NodeId From = Begin; From < End; ++From)
+      for (NodeId To : Gr.getSuccessors(From))
+        if (From == To || IDom[To] != From)
+          Edges.emplace_back(From, To);
+  };
+
+  std::vector<IdEdgeType, Alloc> JoinEdges(Al);
+  ThreadsCount = std::clamp<std::size_t>(ThreadsCount, 1, std::max(Size, 1u));
+  if (ThreadsCount == 1) {
+    Collect(0, Size, JoinEdges);
+    return JoinEdges;
+  }
+
+  std::vector<std::vector<IdEdgeType>> Chunks(ThreadsCount);
+  std::vector<std::thread> Threads;
+  for (std::size_t Idx = 0; Idx < ThreadsCount; ++Idx)
+    Threads.emplace_back([&, Idx] {
+      GRAPHS_STATS_THREAD();
+      Collect(Size * Idx / ThreadsCount, Size * (Idx + 1) / ThreadsCount,
+              Chunks[Idx]);
+    });
+  for (auto &Thread : Threads)
+    Thread.join();
+
+  std::size_t Count = 0;
+  for (auto &Ch : Chunks)
+    Count += Ch.size();
+  JoinEdges.reserve(Count);
+  for (auto &Ch : Chunks)
+    JoinEdges.insert(JoinEdges.end(), Ch.begin(), Ch.end());
+  return JoinEdges;
+}
+
+namespace detail {
+
+/*
+ * Each edge once, ordered by the names of its ends, as the DOT dumps of
+ * the DJ-graph list the join edges. Edges must be grouped by sources in
+ * increasing id order, as findJoinEdges gives them. The names are compared
+ * only to rank the Size nodes, then every source range is sorted by the
+ * ranks of the targets.
+ */
+template <typename EdgeVec, typename NameFunc>
+void sortEdgesByNames(EdgeVec &Edges, std::size_t Size, NameFunc GetName) {
+  GRAPHS_STATS_PHASE("join-sort");
+  std::vector<NodeId> Order(Size);
+  std::iota(Order.begin(), Order.end(), NodeId{0});
+  std::ranges::sort(Order, std::less{}, GetName);
+  std::vector<NodeId> Rank(Size);
+  for (NodeId Pos = 0; Pos < Size; ++Pos)
+    Rank[Order[Pos]] = Pos;
+
+  std::vector<std::size_t> Offsets(Size + 1, 0);
+  for (auto [From, To] : Edges)
+    ++Offsets[From + 1];
+  for (std::size_t Id = 0; Id < Size; ++Id)
+    Offsets[Id + 1] += Offsets[Id];
+
+  EdgeVec Sorted(Edges.get_allocator());
+  Sorted.reserve(Edges.size());
+  std::vector<NodeId> Targets;
+  for (auto From : Order) {
+    Targets.clear();
+    for (auto Idx = Offsets[From]; Idx < Offsets[From + 1]; ++Idx)
+      Targets.push_back(Rank[Edges[Idx].second]);
+    std::ranges::sort(Targets);
+    auto [First, Last] = std::ranges::unique(Targets);
+    for (auto It = Targets.begin(); It != First; ++It)
+      Sorted.emplace_back(From, Order[*It]);
+  }
+  Edges = std::move(Sorted);
+}
+
+} // namespace detail
+
+/*
+ * Dominance frontiers (Cytron et al. as given by Cooper, Harvey, Kennedy):
+ * for every join node b and its predecessor p walk up the dominator tree
+ * from p to idom(b), b is in the frontier of every node on the way.
+ * DF[n] is sorted.
+ */
+template <IndexedGraph G>
+std::vector<std::vector<NodeId>>
+computeDominanceFrontiers(const G &Gr, const IDomArray &IDom) {
+  std::vector<std::vector<NodeId>> DomFront(Gr.size());
+  for (NodeId Join = 0; Join < Gr.size(); ++Join) {
+    if (IDom[Join] == InvalidNodeId)
+      continue;
+    auto Stop = detail::getIDomParent(IDom, Join);
+    for (NodeId Pred : Gr.getPredecessors(Join)) {
+      if (IDom[Pred] == InvalidNodeId)
+        continue;
+      for (auto Runner = Pred; Runner != Stop;
+           Runner = detail::getIDomParent(IDom, Runner)) {
+        // frontiers are filled in increasing join order
+        auto &Front = DomFront[Runner];
+        if (Front.empty() || Front.back() != Join)
+          Front.push_back(Join);
+      }
+    }
+  }
+
+  return DomFront;
+}
+
+// Dominance frontiers in CSR form: DF(n) is the sorted
+// Targets[Offsets[n] .. Offsets[n + 1])
+class FrontierTable final {
+public:
+  using size_type = std::size_t;
+  using OffsetType = std::uint32_t;
+
+  FrontierTable() = default;
+  FrontierTable(std::vector<OffsetType> Offsets, std::vector<NodeId> Targets)
+      : Offsets(std::move(Offsets)), Targets(std::move(Targets)) {}
+
+  size_type size() const noexcept {
+    return Offsets.empty() ? 0 : Offsets.size() - 1;
+  }
+
+  std::span<const NodeId> getFrontier(NodeId Id) const noexcept {
+    return std::span(Targets).subspan(Offsets[Id],
+                                      Offsets[Id + 1] - Offsets[Id]);
+  }
+
+  size_type getEntriesCount() const noexcept { return Targets.size(); }
+
+  const std::vector<OffsetType> &getOffsets() const noexcept {
+    return Offsets;
+  }
+  const std::vector<NodeId> &getTargets() const noexcept { return Targets; }
+
+private:
+  std::vector<OffsetType> Offsets;
+  std::vector<NodeId> Targets;
+};
+
+// Immediate dominators and dominance frontiers of one CFG
+struct DominanceResult final {
+  IDomArray IDom;
+  FrontierTable Frontiers;
+};
+
+/*
+ * The same frontiers straight from the idom array. Only join nodes (two or
+ * more predecessors) and the root can be in a frontier, so the others are
+ * skipped. A walk stops at a node already reached from the same join node,
+ * everything above it has been visited too.
+ *
+ * Join nodes can be split into ThreadsCount ranges. Every thread collects
+ * (node, join) entries and per-node counts in its own buffers; the counts
+ * give each thread its slice of every row, so the rows are filled in
+ * parallel and stay sorted.
+ */
+template <IndexedGraph G>
+FrontierTable computeFrontierTable(const G &Gr, const IDomArray &IDom,
+                                   std::size_t ThreadsCount = 1) {
+  GRAPHS_STATS_PHASE("frontiers");
+  using OffsetType = FrontierTable::OffsetType;
+  auto Size = static_cast<NodeId>(Gr.size());
+
+  struct Chunk final {
+    std::vector<IdEdgeType> Entries;
+    std::vector<OffsetType> Counts;
+  };
+
+  auto Collect = [&](NodeId Begin, NodeId End, Chunk &Ch) {
+    Ch.Counts.assign(Size, 0);
+    std::vector<NodeId> LastJoin(Size, InvalidNodeId);
+    for (NodeId Join = Begin; Join < End; ++Join) {
+      if (IDom[Join] == InvalidNodeId)
+        continue;
+      auto &&Preds = Gr.getPredecessors(Join);
+      if (IDom[Join] != Join && std::ranges::distance(Preds) < 2)
+        continue;
+
+      auto Stop = detail::getIDomParent(IDom, Join);
+      for (NodeId Pred : Preds) {
+        if (IDom[Pred] == InvalidNodeId)
+          continue;
+        for (auto Runner = Pred; Runner != Stop && LastJoin[Runner] != Join;
+             Runner = detail::getIDomParent(IDom, Runner)) {
+          LastJoin[Runner] = Join;
+          Ch.Entries.emplace_back(Runner, Join);
+          ++Ch.Counts[Runner];
+        }
+      }
+    }
+  };
+
+  auto Fill = [](Chunk &Ch, std::vector<NodeId> &Targets) {
+    // Counts hold the slice positions by now
+    for (auto [Runner, Join] : Ch.Entries)
+      Targets[Ch.Counts[Runner]++] = Join;
+  };
+
+  ThreadsCount = std::clamp<std::size_t>(ThreadsCount, 1, std::max(Size, 1u));
+  std::vector<Chunk> Chunks(ThreadsCount);
+  auto RunChunks = [&](auto Task) {
+    if (ThreadsCount == 1)
+      return Task(0);
+    std::vector<std::thread> Threads;
+    for (std::size_t Idx = 0; Idx < ThreadsCount; ++Idx)
+      Threads.emplace_back([&Task, Idx] {
+        GRAPHS_STATS_THREAD();
+        Task(Idx);
+      });
+    for (auto &Thread : Threads)
+      Thread.join();
+  };
+
+  RunChunks([&](std::size_t Idx) {
+    Collect(Size * Idx / ThreadsCount, Size * (Idx + 1) / ThreadsCount,
+            Chunks[Idx]);
+  });
+
+  std::vector<OffsetType> Offsets(Size + 1, 0);
+  for (NodeId Id = 0; Id < Size; ++Id) {
+    Offsets[Id + 1] = Offsets[Id];
+    for (auto &Ch : Chunks)
+      Offsets[Id + 1] += std::exchange(Ch.Counts[Id], Offsets[Id + 1]);
+  }
+
+  std::vector<NodeId> Targets(Offsets.back());
+  RunChunks([&](std::size_t Idx) { Fill(Chunks[Idx], Targets); });
+
+  return FrontierTable(std::move(Offsets), std::move(Targets));
+}
+
+} // namespace graphs
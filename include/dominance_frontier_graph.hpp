@@ -2,85 +2,99 @@
 
 #include <algorithm>
 #include <fstream>
-#include <iterator>
+#include <memory_resource>
 #include <ranges>
-#include <set>
+#include <span>
+#include <stdexcept>
 #include <string_view>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "dominance_tree_graph.hpp"
+#include "statistics.hpp"
 
 namespace graphs {
 
 namespace rgs = std::ranges;
 
-template <typename T>
-concept ForwEdgeIter = InputEdgeIter<T> && std::forward_iterator<T>;
-
 template <typename T> class DomJoinGraph : protected DomTreeGraph<T> {
 protected:
   using DTG = DomTreeGraph<T>;
   using DTG::Nodes;
   using typename DTG::DGT;
-  using typename DTG::NodeTypePtr;
-  using EdgePtrType = std::pair<NodeTypePtr, NodeTypePtr>;
+  using DTG::JoinEdges;
 
 public:
   using DJGT = DomJoinGraph<T>;
-
-  template <ForwEdgeIter FIter>
-  DomJoinGraph(FIter Begin, FIter End) : DTG(Begin, End) {
-    std::unordered_map<std::string, NodeTypePtr> NodeMap;
-    rgs::transform(Nodes, std::inserter(NodeMap, NodeMap.end()),
-                   [](const auto &UnPtr) {
-                     return std::make_pair(UnPtr.get()->getName(), UnPtr.get());
-                   });
-
-    auto Edges = getEdges();
-    std::set<EdgeType> CompSet(Begin, End);
-    std::vector<EdgeType> JoinStringEdges;
-    rgs::set_difference(CompSet, Edges, std::back_inserter(JoinStringEdges));
-
-    rgs::transform(JoinStringEdges, std::back_inserter(JoinEdges),
-                   [&NodeMap](const auto &Edge) {
-                     auto &[V1, V2] = Edge;
-                     return std::make_pair(NodeMap[V1], NodeMap[V2]);
-                   });
+  using typename DTG::allocator_type;
+  using DTG::getAllocator;
+  using DTG::getDomIterations;
+  using DTG::getIDoms;
+  using DTG::findNodeId;
+  using DTG::getNode;
+  using DTG::size;
+
+  template <InputEdgeIter FIter>
+  DomJoinGraph(FIter Begin, FIter End, DomAlgo Algo = DomAlgo::Iterative,
+               const allocator_type &Alloc = {})
+      : DomJoinGraph(rgs::subrange(Begin, End), Algo, Alloc) {}
+
+  template <CfgSource Source>
+  explicit DomJoinGraph(const Source &Cfg, DomAlgo Algo = DomAlgo::Iterative,
+                        const allocator_type &Alloc = {})
+      : DTG(Cfg, Algo, Alloc, true) {
+    sortJoinEdges();
   }
 
+  template <InputEdgeIter FIter>
+  DomJoinGraph(FIter Begin, FIter End, IDomArray IDom,
+               const allocator_type &Alloc = {})
+      : DomJoinGraph(rgs::subrange(Begin, End), std::move(IDom), Alloc, true) {}
+
+  template <CfgSource Source>
+  DomJoinGraph(const Source &Cfg, IDomArray IDom,
+               const allocator_type &Alloc = {})
+      : DomJoinGraph(Cfg, std::move(IDom), Alloc, true) {}
+
   void dumpInDotFormat(std::ofstream &DotDump, std::string_view GraphName,
                        std::string_view NodeShape, std::string_view NodeColor,
                        std::string_view EdgeShape,
-                       std::string_view EdgeColor) const override {
-    DGT::dumpInDotFormatBaseImpl(DotDump, GraphName, NodeShape, NodeColor,
+                       std::string_view EdgeColor,
+                       std::size_t ThreadsCount = 1) const override {
+    DotWriter Writer(DotDump, ThreadsCount);
+    DGT::dumpInDotFormatBaseImpl(Writer, GraphName, NodeShape, NodeColor,
                                  EdgeShape, EdgeColor);
-    rgs::transform(JoinEdges, std::ostream_iterator<std::string>(DotDump),
-                   [](const auto &Edge) {
-                     return utils::formatPrint("{} -> {} [style = dotted];\n",
-                                               Edge.first->getName(),
-                                               Edge.second->getName());
-                   });
-
-    DotDump << "}\n";
+    Writer.writeRange(JoinEdges.size(), [this](std::size_t Idx,
+                                               std::string &Out) {
+      auto [From, To] = JoinEdges[Idx];
+      DotWriter::appendEdge(Out, getName(From), getName(To),
+                            "style = dotted");
+    });
+
+    Writer << "}\n";
   }
 
-private:
-  std::set<EdgeType> getEdges() const {
-    if (Nodes.empty())
-      return {};
+  // J-edges by node ids, as taken by IteratedDominanceFrontier
+  std::span<const IdEdgeType> getJoinEdgeIds() const noexcept {
+    return JoinEdges;
+  }
 
-    std::set<EdgeType> Edges;
-    for (const auto &UnNodePtr : Nodes)
-      for (auto ParentPtr = UnNodePtr.get();
-           const auto *NodePtr : ParentPtr->getSuccessors())
-        Edges.emplace(ParentPtr->getName(), NodePtr->getName());
+protected:
+  template <CfgSource Source>
+  DomJoinGraph(const Source &Cfg, IDomArray IDom, const allocator_type &Alloc,
+               bool KeepJoinEdges)
+      : DTG(Cfg, std::move(IDom), Alloc, KeepJoinEdges) {
+    if (KeepJoinEdges)
+      sortJoinEdges();
+  }
 
-    return Edges;
+private:
+  void sortJoinEdges() {
+    detail::sortEdgesByNames(JoinEdges, size(),
+                             [this](NodeId Id) { return getName(Id); });
   }
 
-protected:
-  std::vector<EdgePtrType> JoinEdges;
+  std::string_view getName(NodeId Id) const { return Nodes[Id]->getName(); }
 };
 
 template <typename T> class DomFrontierGraph final : protected DomJoinGraph<T> {
@@ -88,57 +102,73 @@ template <typename T> class DomFrontierGraph final : protected DomJoinGraph<T> {
   using DJGT::JoinEdges;
   using DJGT::Nodes;
   using typename DJGT::DTG::DGT;
-  using typename DJGT::DTG::NodeTypePtr;
 
   static constexpr std::string_view DefGraphName = "Dominance Frontier";
 
 public:
-  template <ForwEdgeIter FIter>
-  DomFrontierGraph(FIter Begin, FIter End) : DJGT(Begin, End) {
-    std::map<NodeTypePtr, std::set<NodeTypePtr>> DomFront;
-    auto IDom = getImmediateDominatorSet();
-    // making 'join' links
-    rgs::for_each(JoinEdges, [](const auto &EdgePtr) {
-      auto [V1, V2] = EdgePtr;
-      V1->addSuccessor(V2);
-    });
-
-    for (const auto &UniqPtr : Nodes)
-      for (auto ParentPtr = UniqPtr.get();
-           auto *Pred : ParentPtr->getPredecessors())
-        for (auto TmpPtr = Pred; TmpPtr != IDom[ParentPtr];
-             TmpPtr = IDom[TmpPtr])
-          DomFront[TmpPtr].insert(ParentPtr);
+  using typename DJGT::allocator_type;
+  using DJGT::getAllocator;
+  using DJGT::getDomIterations;
+
+  template <InputEdgeIter FIter>
+  DomFrontierGraph(FIter Begin, FIter End, DomAlgo Algo = DomAlgo::Iterative,
+                   const allocator_type &Alloc = {})
+      : DomFrontierGraph(rgs::subrange(Begin, End), Algo, Alloc) {}
+
+  template <CfgSource Source>
+  explicit DomFrontierGraph(const Source &Cfg,
+                            DomAlgo Algo = DomAlgo::Iterative,
+                            const allocator_type &Alloc = {})
+      : DJGT(Cfg, Algo, Alloc) {
+    // making 'join' links: predecessors in the DJ-graph are the CFG ones
+    // plus the idom, which ends a frontier walk right away
+    for (auto [From, To] : JoinEdges)
+      Nodes[From]->addSuccessor(Nodes[To].get());
+    buildFrontierEdges(computeFrontierTable(static_cast<const DGT &>(*this),
+                                            DJGT::getIDoms()));
+  }
 
-    DGT::clearGraphThreads();
-    // building dominance frontier graph
-    for (auto &[Parent, Children] : DomFront) {
-      for (auto *Child : Children)
-        Parent->addSuccessor(Child);
-    }
+  // Dominators and frontiers computed before, e.g. loaded from a
+  // ResultCache: no J-edges are needed then
+  template <InputEdgeIter FIter>
+  DomFrontierGraph(FIter Begin, FIter End, IDomArray IDom,
+                   const FrontierTable &DomFront,
+                   const allocator_type &Alloc = {})
+      : DomFrontierGraph(rgs::subrange(Begin, End), std::move(IDom), DomFront,
+                         Alloc) {}
+
+  template <CfgSource Source>
+  DomFrontierGraph(const Source &Cfg, IDomArray IDom,
+                   const FrontierTable &DomFront,
+                   const allocator_type &Alloc = {})
+      : DJGT(Cfg, std::move(IDom), Alloc, false) {
+    if (DomFront.size() != DJGT::size())
+      throw std::runtime_error("dominance frontiers don't match the graph");
+    buildFrontierEdges(DomFront);
   }
 
   void dumpInDotFormat(std::ofstream &DotDump, std::string_view GraphName,
                        std::string_view NodeShape, std::string_view NodeColor,
                        std::string_view EdgeShape,
-                       std::string_view EdgeColor) const override {
-    DGT::dumpInDotFormatBaseImpl(DotDump, GraphName, NodeShape, NodeColor,
+                       std::string_view EdgeColor,
+                       std::size_t ThreadsCount = 1) const override {
+    DotWriter Writer(DotDump, ThreadsCount);
+    DGT::dumpInDotFormatBaseImpl(Writer, GraphName, NodeShape, NodeColor,
                                  EdgeShape, EdgeColor);
     for (auto &UnPtr : Nodes)
       if (auto *NodePtr = UnPtr.get(); NodePtr->getSuccessorsCount() == 0)
-        DotDump << utils::formatPrint("{};\n", NodePtr->getName());
+        Writer.writeNode(NodePtr->getName());
 
-    DotDump << "}\n";
+    Writer << "}\n";
   }
 
 private:
-  std::unordered_map<NodeTypePtr, NodeTypePtr> getImmediateDominatorSet() {
-    std::unordered_map<NodeTypePtr, NodeTypePtr> ImmediateDomSet;
-    for (const auto &UniqPtr : Nodes)
-      for (auto *Child = UniqPtr.get(); auto *Parent : Child->getPredecessors())
-        ImmediateDomSet.emplace(Child, Parent);
-
-    return ImmediateDomSet;
+  void buildFrontierEdges(const FrontierTable &DomFront) {
+    DGT::clearGraphThreads();
+    // building dominance frontier graph
+    for (NodeId Id = 0; Id < DomFront.size(); ++Id)
+      for (auto Join : DomFront.getFrontier(Id))
+        Nodes[Id]->addSuccessor(Nodes[Join].get());
   }
 };
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "dominance_analysis.hpp"
+#include "dominators.hpp"
+
+namespace graphs {
+
+/*
+ * Dominance queries in O(1): a dominates b iff the DFS interval of b in the
+ * dominator tree lies inside the one of a,
+ *   Pre[a] <= Pre[b] && Post[b] <= Post[a].
+ * As in DomTable, an unreachable node is dominated by every node and
+ * dominates only unreachable ones: it gets the empty interval (max, 0).
+ */
+class DominanceIndex final {
+public:
+  using size_type = std::size_t;
+  using NumType = std::uint32_t;
+
+  DominanceIndex() = default;
+
+  explicit DominanceIndex(const IDomArray &IDom)
+      : Pre(IDom.size(), std::numeric_limits<NumType>::max()),
+        Post(IDom.size(), 0) {
+    auto Size = IDom.size();
+    auto Tree = detail::buildDomTreeChildren(IDom);
+
+    // (node, next child position)
+    std::vector<std::pair<NodeId, NumType>> Stack;
+    NumType PreNum = 0, PostNum = 0;
+    for (NodeId Root = 0; Root < Size; ++Root) {
+      if (IDom[Root] != Root)
+        continue;
+      Pre[Root] = PreNum++;
+      Stack.emplace_back(Root, Tree.Offsets[Root]);
+      while (!Stack.empty()) {
+        auto &[Node, Next] = Stack.back();
+        if (Next == Tree.Offsets[Node + 1]) {
+          Post[Node] = PostNum++;
+          Stack.pop_back();
+          continue;
+        }
+        auto Child = Tree.Children[Next++];
+        Pre[Child] = PreNum++;
+        Stack.emplace_back(Child, Tree.Offsets[Child]);
+      }
+    }
+  }
+
+  size_type size() const noexcept { return Pre.size(); }
+
+  bool dominates(NodeId Dom, NodeId Id) const noexcept {
+    return Pre[Dom] <= Pre[Id] && Post[Id] <= Post[Dom];
+  }
+
+  bool strictlyDominates(NodeId Dom, NodeId Id) const noexcept {
+    return Dom != Id && dominates(Dom, Id);
+  }
+
+  // Answers[i] = dominates(Queries[i].first, Queries[i].second)
+  void dominates(std::span<const IdEdgeType> Queries,
+                 std::span<std::uint8_t> Answers) const noexcept {
+    assert(Queries.size() == Answers.size());
+    for (size_type Idx = 0; Idx < Queries.size(); ++Idx)
+      Answers[Idx] = dominates(Queries[Idx].first, Queries[Idx].second);
+  }
+
+  void strictlyDominates(std::span<const IdEdgeType> Queries,
+                         std::span<std::uint8_t> Answers) const noexcept {
+    assert(Queries.size() == Answers.size());
+    for (size_type Idx = 0; Idx < Queries.size(); ++Idx)
+      Answers[Idx] =
+          strictlyDominates(Queries[Idx].first, Queries[Idx].second);
+  }
+
+  NumType getPreNum(NodeId Id) const noexcept { return Pre[Id]; }
+  NumType getPostNum(NodeId Id) const noexcept { return Post[Id]; }
+
+private:
+  std::vector<NumType> Pre;
+  std::vector<NumType> Post;
+};
+
+} // namespace graphs
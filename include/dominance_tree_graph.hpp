@@ -3,11 +3,13 @@
 #include <algorithm>
 #include <concepts>
 #include <iterator>
-#include <queue>
+#include <memory_resource>
 #include <ranges>
-#include <set>
+#include <stdexcept>
 
 #include "directed_graph.hpp"
+#include "dominance_index.hpp"
+#include "dominator_lca.hpp"
 
 namespace graphs {
 
@@ -22,57 +24,79 @@ public:
   using DTT = DomTreeGraph<T>;
 
   template <InputEdgeIter EdgeIt>
-  DomTreeGraph(EdgeIt FBegin, EdgeIt FEnd) : DGT(FBegin, FEnd) {
-    auto DomTree = getDominatorsTree();
-    // Clean previous graph
-    DGT::clearGraphThreads();
-    // Create tree threads
-    for (auto &[ParentPtr, Children] : DomTree) {
-      for (auto *ChildPtr : Children) {
-        ParentPtr->addSuccessor(ChildPtr);
-      }
-    }
+  DomTreeGraph(EdgeIt FBegin, EdgeIt FEnd, DomAlgo Algo = DomAlgo::Iterative,
+               const GraphAllocator &Alloc = {})
+      : DomTreeGraph(rgs::subrange(FBegin, FEnd), Algo, Alloc, false) {}
+
+  template <CfgSource Source>
+  explicit DomTreeGraph(const Source &Cfg, DomAlgo Algo = DomAlgo::Iterative,
+                        const GraphAllocator &Alloc = {})
+      : DomTreeGraph(Cfg, Algo, Alloc, false) {}
+
+  // Tree of dominators computed before, e.g. loaded from a ResultCache
+  template <InputEdgeIter EdgeIt>
+  DomTreeGraph(EdgeIt FBegin, EdgeIt FEnd, IDomArray IDom,
+               const GraphAllocator &Alloc = {})
+      : DomTreeGraph(rgs::subrange(FBegin, FEnd), std::move(IDom), Alloc,
+                     false) {}
+
+  template <CfgSource Source>
+  DomTreeGraph(const Source &Cfg, IDomArray IDom,
+               const GraphAllocator &Alloc = {})
+      : DomTreeGraph(Cfg, std::move(IDom), Alloc, false) {}
+
+  // fixpoint passes made by an iterative engine, 0 for the others
+  std::size_t getDomIterations() const noexcept { return DomIterations; }
+
+  const IDomArray &getIDoms() const noexcept { return IDom; }
+
+  // O(1) dominates / strictlyDominates queries on this tree
+  DominanceIndex buildDominanceIndex() const { return DominanceIndex(IDom); }
+
+  // O(1) nearest common dominator queries on this tree
+  NearestCommonDominatorIndex buildNearestCommonDominatorIndex() const {
+    return NearestCommonDominatorIndex(IDom);
   }
 
-private:
-  std::map<NodeTypePtr, std::vector<NodeTypePtr>> getDominatorsTree() const {
-    std::map<NodeTypePtr, std::vector<NodeTypePtr>> DomTree;
-
-    for (auto DomTbl = DGT::determineDominators();
-         auto &[NodePtr, DomSet] : DomTbl) {
-      DomSet.erase(NodePtr);
-      if (DomSet.empty()) {
-        continue;
-      } else if (DomSet.size() == 1) {
-        auto *Top = *DomSet.begin();
-        DomTree[Top].push_back(NodePtr);
-      } else {
-        auto *Closest = getClosest(DomSet, NodePtr);
-        assert(Closest);
-        DomTree[Closest].push_back(NodePtr);
-      }
-    }
-
-    return DomTree;
+protected:
+  // With KeepJoinEdges the CFG edges which are not tree edges are saved
+  // in JoinEdges, by ids, before the CFG is gone
+  template <CfgSource Source>
+  DomTreeGraph(const Source &Cfg, DomAlgo Algo, const GraphAllocator &Alloc,
+               bool KeepJoinEdges)
+      : DGT(Cfg, Alloc),
+        IDom(DGT::determineImmediateDominators(Algo, &DomIterations)),
+        JoinEdges(Alloc) {
+    buildTree(KeepJoinEdges);
+  }
+
+  template <CfgSource Source>
+  DomTreeGraph(const Source &Cfg, IDomArray PrecomputedIDom,
+               const GraphAllocator &Alloc, bool KeepJoinEdges)
+      : DGT(Cfg, Alloc), IDom(std::move(PrecomputedIDom)),
+        JoinEdges(Alloc) {
+    if (IDom.size() != DGT::size())
+      throw std::runtime_error("immediate dominators don't match the graph");
+    buildTree(KeepJoinEdges);
   }
 
 private:
-  NodeTypePtr getClosest(const std::set<NodeTypePtr> &DomSet,
-                         NodeTypePtr NodePtr) const {
-    std::queue<NodeTypePtr> BreadthLineNodes;
-    BreadthLineNodes.push(NodePtr);
-    while (!BreadthLineNodes.empty()) {
-      auto *CurrNodePtr = BreadthLineNodes.front();
-      BreadthLineNodes.pop();
-      for (auto *Pred : CurrNodePtr->getPredecessors()) {
-        if (DomSet.contains(Pred))
-          return Pred;
-        BreadthLineNodes.push(Pred);
-      }
-    }
-
-    return nullptr;
+  void buildTree(bool KeepJoinEdges) {
+    if (KeepJoinEdges)
+      JoinEdges = findJoinEdges(*this, IDom, 1, JoinEdges.get_allocator());
+    // Clean previous graph
+    DGT::clearGraphThreads();
+    // Create tree threads
+    for (NodeId Id = 0; Id < IDom.size(); ++Id)
+      if (IDom[Id] != InvalidNodeId && IDom[Id] != Id)
+        Nodes[IDom[Id]]->addSuccessor(Nodes[Id].get());
   }
+
+  std::size_t DomIterations = 0;
+  IDomArray IDom;
+
+protected:
+  std::pmr::vector<IdEdgeType> JoinEdges;
 };
 
 } // namespace graphs
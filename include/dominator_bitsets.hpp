@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GRAPHS_BITSETS_X86 1
+#endif
+
+#include "dominators.hpp"
+
+namespace graphs {
+
+namespace bitrows {
+
+using WordType = std::uint64_t;
+
+// Row operations over Words 64-bit words
+struct Kernels final {
+  // Dst &= Src
+  void (*andInto)(WordType *Dst, const WordType *Src, std::size_t Words);
+  // Dst = Src, returns whether Dst has changed
+  bool (*assignChanged)(WordType *Dst, const WordType *Src, std::size_t Words);
+  const char *Name;
+};
+
+inline void andIntoScalar(WordType *Dst, const WordType *Src,
+                          std::size_t Words) {
+  for (std::size_t I = 0; I < Words; ++I)
+    Dst[I] &= Src[I];
+}
+
+inline bool assignChangedScalar(WordType *Dst, const WordType *Src,
+                                std::size_t Words) {
+  WordType Diff = 0;
+  for (std::size_t I = 0; I < Words; ++I) {
+    Diff |= Dst[I] ^ Src[I];
+    Dst[I] = Src[I];
+  }
+  return Diff != 0;
+}
+
+#ifdef GRAPHS_BITSETS_X86
+
+// Rows are padded to 4 words, so both kernels work on whole 256-bit chunks
+
+__attribute__((target("sse2"))) inline void
+andIntoSSE2(WordType *Dst, const WordType *Src, std::size_t Words) {
+  for (std::size_t I = 0; I < Words; I += 2) {
+    auto D = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Dst + I));
+    auto S = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Src + I));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(Dst + I), _mm_and_si128(D, S));
+  }
+}
+
+__attribute__((target("sse2"))) inline bool
+assignChangedSSE2(WordType *Dst, const WordType *Src, std::size_t Words) {
+  auto Diff = _mm_setzero_si128();
+  for (std::size_t I = 0; I < Words; I += 2) {
+    auto D = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Dst + I));
+    auto S = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Src + I));
+    Diff = _mm_or_si128(Diff, _mm_xor_si128(D, S));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(Dst + I), S);
+  }
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(Diff, _mm_setzero_si128())) !=
+         0xFFFF;
+}
+
+__attribute__((target("avx2"))) inline void
+andIntoAVX2(WordType *Dst, const WordType *Src, std::size_t Words) {
+  for (std::size_t I = 0; I < Words; I += 4) {
+    auto D = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Dst + I));
+    auto S = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Src + I));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(Dst + I),
+                        _mm256_and_si256(D, S));
+  }
+}
+
+__attribute__((target("avx2"))) inline bool
+assignChangedAVX2(WordType *Dst, const WordType *Src, std::size_t Words) {
+  auto Diff = _mm256_setzero_si256();
+  for (std::size_t I = 0; I < Words; I += 4) {
+    auto D = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Dst + I));
+    auto S = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Src + I));
+    Diff = _mm256_or_si256(Diff, _mm256_xor_si256(D, S));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(Dst + I), S);
+  }
+  return !_mm256_testz_si256(Diff, Diff);
+}
+
+#endif // GRAPHS_BITSETS_X86
+
+// Picked once by CPU feature detection
+inline const Kernels &getKernels() {
+  static const Kernels Selected = [] {
+#ifdef GRAPHS_BITSETS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return Kernels{andIntoAVX2, assignChangedAVX2, "avx2"};
+    if (__builtin_cpu_supports("sse2"))
+      return Kernels{andIntoSSE2, assignChangedSSE2, "sse2"};
+#endif
+    return Kernels{andIntoScalar, assignChangedScalar, "scalar"};
+  }();
+  return Selected;
+}
+
+} // namespace bitrows
+
+// N x N bit matrix: row n holds the set of dominators of node n
+class DomBitMatrix final {
+public:
+  using WordType = bitrows::WordType;
+  using size_type = std::size_t;
+
+  static constexpr size_type WordBits = 64;
+  // rows are padded to a whole AVX2 register
+  static constexpr size_type RowAlignWords = 4;
+  static constexpr size_type RowAlignBits = WordBits * RowAlignWords;
+
+  explicit DomBitMatrix(size_type Size = 0)
+      : Size(Size),
+        Words((Size + RowAlignBits - 1) / RowAlignBits * RowAlignWords),
+        Bits(Size * Words, 0) {}
+
+  size_type size() const noexcept { return Size; }
+  size_type getRowWords() const noexcept { return Words; }
+
+  WordType *getRow(NodeId Row) noexcept { return Bits.data() + Row * Words; }
+  const WordType *getRow(NodeId Row) const noexcept {
+    return Bits.data() + Row * Words;
+  }
+
+  bool test(NodeId Row, NodeId Col) const noexcept {
+    return getRow(Row)[Col / WordBits] >> (Col % WordBits) & 1;
+  }
+
+  void set(NodeId Row, NodeId Col) noexcept {
+    getRow(Row)[Col / WordBits] |= WordType{1} << (Col % WordBits);
+  }
+
+  // set all Size bits of the row, padding bits stay zero
+  void fill(NodeId Row) noexcept {
+    auto *RowPtr = getRow(Row);
+    std::fill_n(RowPtr, Size / WordBits, ~WordType{0});
+    if (auto Tail = Size % WordBits)
+      RowPtr[Size / WordBits] = (WordType{1} << Tail) - 1;
+  }
+
+  size_type count(NodeId Row) const noexcept {
+    size_type Count = 0;
+    for (auto *RowPtr = getRow(Row), *End = RowPtr + Words; RowPtr != End;
+         ++RowPtr)
+      Count += std::popcount(*RowPtr);
+    return Count;
+  }
+
+  // call Fn(Col) for every set bit of the row
+  template <typename Func> void forEach(NodeId Row, Func Fn) const {
+    auto *RowPtr = getRow(Row);
+    for (size_type WordIdx = 0; WordIdx < Words; ++WordIdx)
+      for (auto Word = RowPtr[WordIdx]; Word; Word &= Word - 1)
+        Fn(static_cast<NodeId>(WordIdx * WordBits + std::countr_zero(Word)));
+  }
+
+private:
+  size_type Size;
+  size_type Words;
+  std::vector<WordType> Bits;
+};
+
+/*
+ * Dom(n) = n \/ ( /\ Dom(m)), where m is a set of predecessors of the n.
+ * Every row starts full, the root row holds only the root. Nodes are
+ * taken from a worklist seeded in reverse postorder, and a node's
+ * successors are queued again only when its row has changed.
+ */
+template <IndexedGraph G>
+DomBitMatrix computeDominatorBits(const G &Gr, NodeId Root = 0) {
+  auto Size = static_cast<NodeId>(Gr.size());
+  DomBitMatrix Dom(Size);
+  if (Size == 0)
+    return Dom;
+
+  for (NodeId Row = 0; Row < Size; ++Row)
+    Dom.fill(Row);
+  std::fill_n(Dom.getRow(Root), Dom.getRowWords(), 0);
+  Dom.set(Root, Root);
+
+  const auto &Kernels = bitrows::getKernels();
+  auto Words = Dom.getRowWords();
+  std::vector<DomBitMatrix::WordType> Tmp(Words);
+
+  auto PostOrder = detail::buildPostOrder(Gr, Root);
+  std::vector<NodeId> WorkList(PostOrder.rbegin(), PostOrder.rend());
+  std::vector<bool> InList(Size, false);
+  for (auto Node : WorkList)
+    InList[Node] = true;
+
+  // WorkList is used as a FIFO ring, it never holds more than Size nodes
+  WorkList.resize(Size);
+  std::size_t Head = 0, Count = PostOrder.size();
+  std::size_t Visits = 0, Intersections = 0;
+  while (Count) {
+    auto Node = WorkList[Head];
+    Head = (Head + 1) % Size;
+    --Count;
+    InList[Node] = false;
+    if (Node == Root)
+      continue;
+
+    ++Visits;
+    bool First = true;
+    for (NodeId Pred : Gr.getPredecessors(Node)) {
+      if (First) {
+        std::copy_n(Dom.getRow(Pred), Words, Tmp.data());
+      } else {
+        Kernels.andInto(Tmp.data(), Dom.getRow(Pred), Words);
+        ++Intersections;
+      }
+      First = false;
+    }
+    Tmp[Node / DomBitMatrix::WordBits] |= DomBitMatrix::WordType{1}
+                                          << (Node % DomBitMatrix::WordBits);
+
+    if (!Kernels.assignChanged(Dom.getRow(Node), Tmp.data(), Words))
+      continue;
+    for (NodeId Succ : Gr.getSuccessors(Node)) {
+      if (InList[Succ])
+        continue;
+      InList[Succ] = true;
+      WorkList[(Head + Count++) % Size] = Succ;
+    }
+  }
+
+  GRAPHS_STATS_COUNT("dom.worklist_visits", Visits);
+  GRAPHS_STATS_COUNT("dom.set_intersections", Intersections);
+  return Dom;
+}
+
+} // namespace graphs
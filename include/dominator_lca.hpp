@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "dominance_analysis.hpp"
+#include "dominators.hpp"
+
+namespace graphs {
+
+/*
+ * Nearest common dominator (LCA in the dominator tree) in O(1). The Euler
+ * tour of the tree lists a node every time the walk enters or returns to
+ * it, so the LCA of a and b is the shallowest node of the tour between
+ * their first occurrences. A sparse table keeps the shallowest node of
+ * every 2^k long tour window, any range is covered by two of them.
+ * Building takes O(N log N) from the idom array.
+ *
+ * Unreachable nodes are dominated by every node, so they are skipped: the
+ * NCD of a reachable a and an unreachable b is a. InvalidNodeId is
+ * returned when no reachable node is given.
+ */
+class NearestCommonDominatorIndex final {
+public:
+  using size_type = std::size_t;
+  using PosType = std::uint32_t;
+
+  static constexpr PosType NoPos = ~PosType{0};
+
+  NearestCommonDominatorIndex() = default;
+
+  explicit NearestCommonDominatorIndex(const IDomArray &IDom)
+      : First(IDom.size(), NoPos), Depth(IDom.size(), 0) {
+    buildEulerTour(IDom);
+    buildSparseTable();
+  }
+
+  size_type size() const noexcept { return First.size(); }
+
+  NodeId findNearestCommonDominator(NodeId Lhs, NodeId Rhs) const noexcept {
+    auto LhsPos = First[Lhs], RhsPos = First[Rhs];
+    if (LhsPos == NoPos)
+      return RhsPos == NoPos ? InvalidNodeId : Rhs;
+    if (RhsPos == NoPos)
+      return Lhs;
+    return findShallowest(std::min(LhsPos, RhsPos), std::max(LhsPos, RhsPos));
+  }
+
+  // The NCD of a set is the NCD of its two nodes entered first and last by
+  // the tour, so the fold takes a single range query
+  NodeId
+  findNearestCommonDominator(std::span<const NodeId> Nodes) const noexcept {
+    PosType MinPos = NoPos, MaxPos = 0;
+    for (auto Node : Nodes) {
+      if (auto Pos = First[Node]; Pos != NoPos) {
+        MinPos = std::min(MinPos, Pos);
+        MaxPos = std::max(MaxPos, Pos);
+      }
+    }
+    return MinPos == NoPos ? InvalidNodeId : findShallowest(MinPos, MaxPos);
+  }
+
+  size_type getDepth(NodeId Id) const noexcept { return Depth[Id]; }
+
+private:
+  void buildEulerTour(const IDomArray &IDom) {
+    auto Tree = detail::buildDomTreeChildren(IDom);
+    // the tour is the first level of the sparse table
+    auto &Tour = Levels.emplace_back();
+    Tour.reserve(2 * IDom.size());
+
+    // (node, next child position)
+    std::vector<std::pair<NodeId, std::uint32_t>> Stack;
+    for (NodeId Root = 0; Root < IDom.size(); ++Root) {
+      if (IDom[Root] != Root)
+        continue;
+      First[Root] = Tour.size();
+      Tour.push_back(Root);
+      Stack.emplace_back(Root, Tree.Offsets[Root]);
+      while (!Stack.empty()) {
+        auto &[Node, Next] = Stack.back();
+        if (Next == Tree.Offsets[Node + 1]) {
+          Stack.pop_back();
+          if (!Stack.empty())
+            Tour.push_back(Stack.back().first);
+          continue;
+        }
+        auto Child = Tree.Children[Next++];
+        Depth[Child] = Depth[Node] + 1;
+        First[Child] = Tour.size();
+        Tour.push_back(Child);
+        Stack.emplace_back(Child, Tree.Offsets[Child]);
+      }
+    }
+  }
+
+  NodeId getShallower(NodeId Lhs, NodeId Rhs) const noexcept {
+    return Depth[Rhs] < Depth[Lhs] ? Rhs : Lhs;
+  }
+
+  // Level k holds the shallowest node of Tour[i .. i + 2^k)
+  void buildSparseTable() {
+    auto Size = Levels.front().size();
+    for (size_type Width = 1; 2 * Width <= Size; Width *= 2) {
+      const auto &Prev = Levels.back();
+      std::vector<NodeId> Level(Size - 2 * Width + 1);
+      for (size_type Idx = 0; Idx < Level.size(); ++Idx)
+        Level[Idx] = getShallower(Prev[Idx], Prev[Idx + Width]);
+      Levels.push_back(std::move(Level));
+    }
+  }
+
+  NodeId findShallowest(PosType Begin, PosType Last) const noexcept {
+    auto K = std::bit_width(Last - Begin + 1) - 1;
+    const auto &Level = Levels[K];
+    return getShallower(Level[Begin], Level[Last + 1 - (PosType{1} << K)]);
+  }
+
+private:
+  std::vector<PosType> First;
+  std::vector<std::uint32_t> Depth;
+  std::vector<std::vector<NodeId>> Levels;
+};
+
+} // namespace graphs
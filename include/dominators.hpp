@@ -0,0 +1,344 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "statistics.hpp"
+
+namespace graphs {
+
+namespace rgs = std::ranges;
+
+using NodeId = std::uint32_t;
+// IDom[n] is the immediate dominator of n. The root is its own immediate
+// dominator and nodes unreachable from the root get InvalidNodeId.
+using IDomArray = std::vector<NodeId>;
+
+inline constexpr NodeId InvalidNodeId = std::numeric_limits<NodeId>::max();
+
+// Graph with dense node ids [0, size()) and adjacency given as ranges of ids
+template <typename T>
+concept IndexedGraph = requires(const T &Gr, NodeId Id) {
+  { Gr.size() } -> std::convertible_to<std::size_t>;
+  { Gr.getSuccessors(Id) } -> rgs::input_range;
+  { Gr.getPredecessors(Id) } -> rgs::input_range;
+};
+
+enum class DomAlgo : char {
+  Iterative,
+  LengauerTarjan,
+  SemiNCA,
+  CooperHarveyKennedy
+};
+
+namespace dom_algo_names {
+
+constexpr std::string_view Iterative = "iterative";
+constexpr std::string_view LengauerTarjan = "lt";
+constexpr std::string_view SemiNCA = "seminca";
+constexpr std::string_view CooperHarveyKennedy = "chk";
+
+} // namespace dom_algo_names
+
+inline std::optional<DomAlgo> getDomAlgo(std::string_view Name) {
+  if (Name == dom_algo_names::Iterative)
+    return DomAlgo::Iterative;
+  if (Name == dom_algo_names::LengauerTarjan)
+    return DomAlgo::LengauerTarjan;
+  if (Name == dom_algo_names::SemiNCA)
+    return DomAlgo::SemiNCA;
+  if (Name == dom_algo_names::CooperHarveyKennedy)
+    return DomAlgo::CooperHarveyKennedy;
+  return std::nullopt;
+}
+
+namespace detail {
+
+// Depth-first spanning tree of the nodes reachable from the root.
+// Vertices are numbered 1..N in preorder, 0 is used as "not visited".
+struct DFSTree final {
+  std::vector<NodeId> Num;    // node -> preorder number
+  std::vector<NodeId> Vertex; // preorder number -> node
+  std::vector<NodeId> Parent; // preorder number -> parent preorder number
+
+  NodeId size() const noexcept { return Vertex.size() - 1; }
+};
+
+template <IndexedGraph G> DFSTree buildDFSTree(const G &Gr, NodeId Root) {
+  DFSTree Tree;
+  auto Size = static_cast<NodeId>(Gr.size());
+  Tree.Num.assign(Size, 0);
+  Tree.Vertex.reserve(Size + 1);
+  Tree.Parent.reserve(Size + 1);
+  Tree.Vertex.push_back(InvalidNodeId);
+  Tree.Parent.push_back(0);
+
+  // (node, preorder number of the node that discovered it)
+  std::vector<std::pair<NodeId, NodeId>> Stack{{Root, 0}};
+  while (!Stack.empty()) {
+    auto [Node, ParentNum] = Stack.back();
+    Stack.pop_back();
+    if (Tree.Num[Node])
+      continue;
+    Tree.Vertex.push_back(Node);
+    Tree.Parent.push_back(ParentNum);
+    auto Number = Tree.Num[Node] = Tree.size();
+    for (NodeId Succ : Gr.getSuccessors(Node))
+      if (!Tree.Num[Succ])
+        Stack.emplace_back(Succ, Number);
+  }
+
+  GRAPHS_STATS_COUNT("dom.dfs_visits", Tree.size());
+  return Tree;
+}
+
+// Postorder of the nodes reachable from the root
+template <IndexedGraph G>
+std::vector<NodeId> buildPostOrder(const G &Gr, NodeId Root) {
+  std::vector<NodeId> PostOrder;
+  std::vector<bool> Visited(Gr.size(), false);
+  PostOrder.reserve(Gr.size());
+
+  // (node, all successors already visited)
+  std::vector<std::pair<NodeId, bool>> Stack{{Root, false}};
+  while (!Stack.empty()) {
+    auto [Node, Finished] = Stack.back();
+    Stack.pop_back();
+    if (Finished) {
+      PostOrder.push_back(Node);
+      continue;
+    }
+    if (Visited[Node])
+      continue;
+    Visited[Node] = true;
+    Stack.emplace_back(Node, true);
+    for (NodeId Succ : Gr.getSuccessors(Node))
+      if (!Visited[Succ])
+        Stack.emplace_back(Succ, false);
+  }
+
+  GRAPHS_STATS_COUNT("dom.dfs_visits", PostOrder.size());
+  return PostOrder;
+}
+
+// Translate dominators given in preorder numbers back to node ids
+inline IDomArray toIDomArray(const DFSTree &Tree,
+                             const std::vector<NodeId> &NumIDom,
+                             std::size_t Size) {
+  IDomArray IDom(Size, InvalidNodeId);
+  if (Tree.size() == 0)
+    return IDom;
+
+  IDom[Tree.Vertex[1]] = Tree.Vertex[1];
+  for (NodeId W = 2; W <= Tree.size(); ++W)
+    IDom[Tree.Vertex[W]] = Tree.Vertex[NumIDom[W]];
+
+  return IDom;
+}
+
+} // namespace detail
+
+/*
+ * Lengauer-Tarjan "simple" version: semidominators are computed with
+ * path-compressed EVAL over the spanning forest, immediate dominators
+ * are resolved through buckets. O(E log N).
+ */
+template <IndexedGraph G>
+IDomArray computeIDomLengauerTarjan(const G &Gr, NodeId Root = 0) {
+  if (Gr.size() == 0)
+    return {};
+
+  auto Tree = detail::buildDFSTree(Gr, Root);
+  auto N = Tree.size();
+
+  std::vector<NodeId> Semi(N + 1), Label(N + 1), Ancestor(N + 1, 0),
+      IDom(N + 1, 0);
+  // buckets are intrusive lists: no allocations inside the main loop
+  std::vector<NodeId> BucketHead(N + 1, 0), BucketNext(N + 1, 0);
+  std::vector<NodeId> PathStack;
+  for (NodeId V = 0; V <= N; ++V)
+    Semi[V] = Label[V] = V;
+
+  auto Eval = [&](NodeId V) {
+    if (!Ancestor[V])
+      return V;
+    for (auto X = V; Ancestor[Ancestor[X]]; X = Ancestor[X])
+      PathStack.push_back(X);
+    while (!PathStack.empty()) {
+      auto X = PathStack.back();
+      PathStack.pop_back();
+      if (Semi[Label[Ancestor[X]]] < Semi[Label[X]])
+        Label[X] = Label[Ancestor[X]];
+      Ancestor[X] = Ancestor[Ancestor[X]];
+    }
+    return Label[V];
+  };
+
+  for (auto W = N; W >= 2; --W) {
+    for (NodeId Pred : Gr.getPredecessors(Tree.Vertex[W])) {
+      auto PredNum = Tree.Num[Pred];
+      if (!PredNum)
+        continue;
+      if (auto U = Eval(PredNum); Semi[U] < Semi[W])
+        Semi[W] = Semi[U];
+    }
+    BucketNext[W] = BucketHead[Semi[W]];
+    BucketHead[Semi[W]] = W;
+
+    auto P = Tree.Parent[W];
+    Ancestor[W] = P;
+    for (auto V = BucketHead[P]; V; V = BucketNext[V]) {
+      auto U = Eval(V);
+      IDom[V] = Semi[U] < Semi[V] ? U : P;
+    }
+    BucketHead[P] = 0;
+  }
+
+  for (NodeId W = 2; W <= N; ++W)
+    if (IDom[W] != Semi[W])
+      IDom[W] = IDom[IDom[W]];
+
+  return detail::toIDomArray(Tree, IDom, Gr.size());
+}
+
+/*
+ * SEMI-NCA: semidominators as in Lengauer-Tarjan, then
+ * idom(w) = NCA(parent(w), sdom(w)) found by walking the partially built
+ * dominator tree. O(N^2) worst case, linear-ish on real CFGs.
+ */
+template <IndexedGraph G>
+IDomArray computeIDomSemiNCA(const G &Gr, NodeId Root = 0) {
+  if (Gr.size() == 0)
+    return {};
+
+  auto Tree = detail::buildDFSTree(Gr, Root);
+  auto N = Tree.size();
+
+  // Ancestor starts as the spanning tree parent and gets compressed by Eval
+  std::vector<NodeId> Semi(N + 1), Label(N + 1), Ancestor(Tree.Parent),
+      IDom(Tree.Parent);
+  std::vector<NodeId> PathStack;
+  for (NodeId V = 0; V <= N; ++V)
+    Semi[V] = Label[V] = V;
+
+  // Vertices numbered >= LastLinked are already linked into the forest
+  auto Eval = [&](NodeId V, NodeId LastLinked) {
+    if (Ancestor[V] < LastLinked)
+      return Label[V];
+    auto X = V;
+    do {
+      PathStack.push_back(X);
+      X = Ancestor[X];
+    } while (Ancestor[X] >= LastLinked);
+
+    auto P = X;
+    auto PLabel = Label[P];
+    do {
+      X = PathStack.back();
+      PathStack.pop_back();
+      Ancestor[X] = Ancestor[P];
+      if (Semi[PLabel] < Semi[Label[X]])
+        Label[X] = PLabel;
+      else
+        PLabel = Label[X];
+      P = X;
+    } while (!PathStack.empty());
+    return Label[X];
+  };
+
+  for (auto W = N; W >= 2; --W) {
+    Semi[W] = Tree.Parent[W];
+    for (NodeId Pred : Gr.getPredecessors(Tree.Vertex[W])) {
+      auto PredNum = Tree.Num[Pred];
+      if (!PredNum)
+        continue;
+      if (auto SemiU = Semi[Eval(PredNum, W + 1)]; SemiU < Semi[W])
+        Semi[W] = SemiU;
+    }
+  }
+
+  for (NodeId W = 2; W <= N; ++W) {
+    auto Candidate = IDom[W];
+    while (Candidate > Semi[W])
+      Candidate = IDom[Candidate];
+    IDom[W] = Candidate;
+  }
+
+  return detail::toIDomArray(Tree, IDom, Gr.size());
+}
+
+/*
+ * Cooper, Harvey, Kennedy "A Simple, Fast Dominance Algorithm".
+ * Nodes are numbered in postorder and visited in reverse postorder, the
+ * idom array holds postorder numbers, so intersecting two dominator chains
+ * is a walk of two fingers towards the root (which has the largest number).
+ * Nothing is allocated inside the fixpoint loop. The number of passes over
+ * the nodes is written to Iterations: it is 2 for reducible CFGs visited in
+ * a good order and grows on irreducible ones.
+ */
+template <IndexedGraph G>
+IDomArray computeIDomCooperHarveyKennedy(const G &Gr, NodeId Root = 0,
+                                         std::size_t *Iterations = nullptr) {
+  if (Gr.size() == 0)
+    return {};
+
+  auto PostOrder = detail::buildPostOrder(Gr, Root);
+  std::vector<std::uint32_t> PostNum(Gr.size(), InvalidNodeId);
+  for (std::uint32_t Num = 0; Num < PostOrder.size(); ++Num)
+    PostNum[PostOrder[Num]] = Num;
+
+  auto RootNum = static_cast<std::uint32_t>(PostOrder.size() - 1);
+  std::vector<std::uint32_t> Doms(PostOrder.size(), InvalidNodeId);
+  Doms[RootNum] = RootNum;
+
+  std::size_t Intersections = 0;
+  auto Intersect = [&](std::uint32_t Finger1, std::uint32_t Finger2) {
+    ++Intersections;
+    while (Finger1 != Finger2) {
+      while (Finger1 < Finger2)
+        Finger1 = Doms[Finger1];
+      while (Finger2 < Finger1)
+        Finger2 = Doms[Finger2];
+    }
+    return Finger1;
+  };
+
+  std::size_t Passes = 0;
+  for (bool Changed = true; Changed;) {
+    Changed = false;
+    ++Passes;
+    for (auto Num = RootNum; Num-- > 0;) {
+      std::uint32_t NewIDom = InvalidNodeId;
+      for (NodeId Pred : Gr.getPredecessors(PostOrder[Num])) {
+        auto PredNum = PostNum[Pred];
+        if (PredNum == InvalidNodeId || Doms[PredNum] == InvalidNodeId)
+          continue;
+        NewIDom =
+            NewIDom == InvalidNodeId ? PredNum : Intersect(PredNum, NewIDom);
+      }
+      if (Doms[Num] != NewIDom) {
+        Doms[Num] = NewIDom;
+        Changed = true;
+      }
+    }
+  }
+
+  if (Iterations)
+    *Iterations = Passes;
+  GRAPHS_STATS_COUNT("dom.fixpoint_iterations", Passes);
+  GRAPHS_STATS_COUNT("dom.set_intersections", Intersections);
+
+  IDomArray IDom(Gr.size(), InvalidNodeId);
+  for (std::uint32_t Num = 0; Num <= RootNum; ++Num)
+    IDom[PostOrder[Num]] = PostOrder[Doms[Num]];
+
+  return IDom;
+}
+
+} // namespace graphs
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "utils.hpp"
+
+namespace graphs {
+
+// Graph label and the default node and edge attributes of a DOT file
+struct DotStyle final {
+  std::string_view GraphName;
+  std::string_view NodeShape;
+  std::string_view NodeColor;
+  std::string_view EdgeShape;
+  std::string_view EdgeColor;
+};
+
+/*
+ * Buffered DOT output. Lines are appended to a reusable buffer which goes
+ * to the stream in large writes, nothing is formatted per edge. Long
+ * ranges of lines (e.g. edges of every node) can be rendered by several
+ * threads in chunks which are written in order, so the output is the same
+ * for any ThreadsCount.
+ */
+class DotWriter final {
+public:
+  using size_type = std::size_t;
+
+  static constexpr size_type BufferSize = 1 << 20;
+  // items rendered by one parallel task
+  static constexpr size_type ChunkSize = 1 << 14;
+
+  explicit DotWriter(std::ostream &Os, size_type ThreadsCount = 1)
+      : Os(Os), ThreadsCount(std::max<size_type>(ThreadsCount, 1)) {
+    Buffer.reserve(BufferSize);
+  }
+
+  DotWriter(const DotWriter &) = delete;
+  DotWriter &operator=(const DotWriter &) = delete;
+
+  ~DotWriter() { flush(); }
+
+  DotWriter &operator<<(std::string_view Str) {
+    Buffer.append(Str);
+    flushIfFull();
+    return *this;
+  }
+
+  // Opens the digraph, the caller closes it with "}\n"
+  void writeHeader(const DotStyle &Style) {
+    *this << utils::formatPrint(
+        "digraph {} {}\n"
+        "\tlabel=\"{}\"\n"
+        "\tdpi = 100;\n"
+        "\tfontname = \"Comic Sans MS\";\n"
+        "\tfontsize = 20;\n"
+        "\trankdir  = TB;\n"
+        "node [shape = {}, style = filled, fillcolor = \"{}\"];\n"
+        "edge [color = {}, arrowhead = {}, arrowsize = 1,"
+        "penwidth = 1.2];\n",
+        Style.GraphName, '{', Style.GraphName, Style.NodeShape,
+        Style.NodeColor, Style.EdgeColor, Style.EdgeShape);
+  }
+
+  // "From -> To [Attrs];\n"
+  static void appendEdge(std::string &Out, std::string_view From,
+                         std::string_view To, std::string_view Attrs = {}) {
+    Out.append(From).append(" -> ").append(To);
+    if (!Attrs.empty())
+      Out.append(" [").append(Attrs).push_back(']');
+    Out.append(";\n");
+  }
+
+  void writeEdge(std::string_view From, std::string_view To,
+                 std::string_view Attrs = {}) {
+    appendEdge(Buffer, From, To, Attrs);
+    flushIfFull();
+  }
+
+  // "Name;\n"
+  void writeNode(std::string_view Name) {
+    Buffer.append(Name).append(";\n");
+    flushIfFull();
+  }
+
+  // Render(Idx, Out) appends the lines of item Idx to Out, it is called
+  // concurrently for different items when the range is long enough
+  template <typename Func> void writeRange(size_type Count, Func Render) {
+    auto ChunksCount = (Count + ChunkSize - 1) / ChunkSize;
+    if (ThreadsCount == 1 || ChunksCount < 2) {
+      for (size_type Idx = 0; Idx < Count; ++Idx) {
+        Render(Idx, Buffer);
+        flushIfFull();
+      }
+      return;
+    }
+
+    flush();
+    ThreadPool Pool(std::min(ThreadsCount, ChunksCount));
+    // a few chunks per thread are kept in memory at once
+    auto Window = Pool.size() * 4;
+    std::vector<std::string> Parts(Window);
+    for (size_type Begin = 0; Begin < ChunksCount; Begin += Window) {
+      auto End = std::min(ChunksCount, Begin + Window);
+      for (auto Chunk = Begin; Chunk < End; ++Chunk)
+        Pool.submit([&, Chunk] {
+          auto &Part = Parts[Chunk - Begin];
+          Part.clear();
+          for (auto Idx = Chunk * ChunkSize;
+               Idx < std::min(Count, (Chunk + 1) * ChunkSize); ++Idx)
+            Render(Idx, Part);
+        });
+      Pool.wait();
+      for (auto Chunk = Begin; Chunk < End; ++Chunk) {
+        const auto &Part = Parts[Chunk - Begin];
+        Os.write(Part.data(), Part.size());
+      }
+    }
+  }
+
+  void flush() {
+    Os.write(Buffer.data(), Buffer.size());
+    Buffer.clear();
+  }
+
+private:
+  void flushIfFull() {
+    if (Buffer.size() >= BufferSize)
+      flush();
+  }
+
+  std::ostream &Os;
+  size_type ThreadsCount;
+  std::string Buffer;
+};
+
+} // namespace graphs
@@ -0,0 +1,405 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <queue>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "dominance_analysis.hpp"
+#include "dominators.hpp"
+
+namespace graphs {
+
+/*
+ * Dominator tree and dominance frontiers of a mutable CFG, kept up to date
+ * under single edge insertions and deletions.
+ *
+ * Insertion of a reachable edge uses the depth-based search of Georgiadis,
+ * Italiano, Laura, Santaroni ("An Experimental Study of Dynamic
+ * Dominators"): only nodes deeper than NCA(from, to) + 1 that are reached
+ * from `to` through nodes not shallower than themselves are affected, and
+ * they all get NCA(from, to) as the new idom. An edge making new nodes
+ * reachable gets their dominators from SEMI-NCA over the new region first.
+ * Deletion rebuilds the subtree rooted at NCA(from, to) with SEMI-NCA, no
+ * node outside of it can change.
+ *
+ * Frontiers of a join node depend only on its predecessors and on the
+ * tree, so an update that leaves the tree alone recomputes the frontier
+ * entries of the edge target only. When the tree changes the frontiers are
+ * recomputed from the idom array in linear time.
+ */
+class DynamicDominators final {
+public:
+  using size_type = std::size_t;
+
+  explicit DynamicDominators(size_type NodesCount = 0, NodeId Root = 0)
+      : Root(Root), Successors(NodesCount), Predecessors(NodesCount) {
+    rebuild();
+  }
+
+  template <IndexedGraph G>
+  explicit DynamicDominators(const G &Gr, NodeId Root = 0)
+      : Root(Root), Successors(Gr.size()), Predecessors(Gr.size()) {
+    for (NodeId From = 0; From < Gr.size(); ++From)
+      for (NodeId To : Gr.getSuccessors(From)) {
+        Successors[From].push_back(To);
+        Predecessors[To].push_back(From);
+      }
+    rebuild();
+  }
+
+  // IndexedGraph interface
+  size_type size() const noexcept { return Successors.size(); }
+  std::span<const NodeId> getSuccessors(NodeId Id) const noexcept {
+    return Successors[Id];
+  }
+  std::span<const NodeId> getPredecessors(NodeId Id) const noexcept {
+    return Predecessors[Id];
+  }
+
+  NodeId getRoot() const noexcept { return Root; }
+  const IDomArray &getIDoms() const noexcept { return IDom; }
+  NodeId getIDom(NodeId Id) const noexcept { return IDom[Id]; }
+  size_type getDepth(NodeId Id) const noexcept { return Depth[Id]; }
+  bool isReachable(NodeId Id) const noexcept {
+    return IDom[Id] != InvalidNodeId;
+  }
+
+  // sorted dominance frontier of the node
+  std::span<const NodeId> getFrontier(NodeId Id) const noexcept {
+    return DomFront[Id];
+  }
+
+  bool dominates(NodeId Dom, NodeId Id) const noexcept {
+    if (!isReachable(Dom) || !isReachable(Id))
+      return false;
+    while (Depth[Id] > Depth[Dom])
+      Id = IDom[Id];
+    return Id == Dom;
+  }
+
+  // new unreachable node without edges
+  NodeId addNode() {
+    auto Id = static_cast<NodeId>(size());
+    Successors.emplace_back();
+    Predecessors.emplace_back();
+    IDom.push_back(InvalidNodeId);
+    Depth.push_back(0);
+    Children.emplace_back();
+    DomFront.emplace_back();
+    FrontOwners.emplace_back();
+    LocalIds.push_back(InvalidNodeId);
+    return Id;
+  }
+
+  void insertEdge(NodeId From, NodeId To) {
+    Successors[From].push_back(To);
+    Predecessors[To].push_back(From);
+    if (!isReachable(From))
+      return;
+
+    bool TreeChanged = isReachable(To) ? insertReachable(From, To)
+                                       : insertUnreachable(From, To);
+    if (TreeChanged)
+      rebuildFrontiers();
+    else
+      updateFrontiersOf(To);
+  }
+
+  // removes one From -> To edge, returns false if there is no such edge
+  bool deleteEdge(NodeId From, NodeId To) {
+    auto &Succs = Successors[From];
+    auto SuccIt = std::ranges::find(Succs, To);
+    if (SuccIt == Succs.end())
+      return false;
+    Succs.erase(SuccIt);
+    auto &Preds = Predecessors[To];
+    Preds.erase(std::ranges::find(Preds, From));
+
+    // a parallel edge is still there or the edge was not on any path
+    if (!isReachable(From) || !isReachable(To) ||
+        std::ranges::find(Succs, To) != Succs.end())
+      return true;
+
+    // To dominates From: every path using the edge has visited To before
+    auto NCA = findNCA(From, To);
+    if (NCA != To && rebuildSubtree(NCA))
+      rebuildFrontiers();
+    else
+      updateFrontiersOf(To);
+    return true;
+  }
+
+private:
+  // Subgraph induced by LocalNodes, node ids are positions in LocalNodes
+  struct LocalView final {
+    const DynamicDominators &Dyn;
+
+    auto toLocal(const std::vector<NodeId> &Adj) const {
+      const auto &LocalIds = Dyn.LocalIds;
+      return Adj | std::views::filter([&LocalIds](NodeId Node) {
+               return LocalIds[Node] != InvalidNodeId;
+             }) |
+             std::views::transform(
+                 [&LocalIds](NodeId Node) { return LocalIds[Node]; });
+    }
+
+    size_type size() const noexcept { return Dyn.LocalNodes.size(); }
+    auto getSuccessors(NodeId Id) const {
+      return toLocal(Dyn.Successors[Dyn.LocalNodes[Id]]);
+    }
+    auto getPredecessors(NodeId Id) const {
+      return toLocal(Dyn.Predecessors[Dyn.LocalNodes[Id]]);
+    }
+  };
+
+  void rebuild() {
+    auto Size = size();
+    IDom = computeIDomSemiNCA(*this, Root);
+    Children.assign(Size, {});
+    Depth.assign(Size, 0);
+    LocalIds.assign(Size, InvalidNodeId);
+    for (NodeId Id = 0; Id < Size; ++Id)
+      if (isReachable(Id) && Id != Root)
+        Children[IDom[Id]].push_back(Id);
+    if (Size)
+      updateDepths(Root, 0);
+    rebuildFrontiers();
+  }
+
+  NodeId findNCA(NodeId Lhs, NodeId Rhs) const noexcept {
+    while (Lhs != Rhs) {
+      if (Depth[Lhs] < Depth[Rhs])
+        Rhs = IDom[Rhs];
+      else
+        Lhs = IDom[Lhs];
+    }
+    return Lhs;
+  }
+
+  void setIDom(NodeId Id, NodeId NewIDom) {
+    if (IDom[Id] == NewIDom)
+      return;
+    if (isReachable(Id) && Id != Root)
+      std::erase(Children[IDom[Id]], Id);
+    IDom[Id] = NewIDom;
+    if (NewIDom != InvalidNodeId)
+      Children[NewIDom].push_back(Id);
+  }
+
+  // depths of the subtree rooted at Top
+  void updateDepths(NodeId Top, size_type TopDepth) {
+    Depth[Top] = TopDepth;
+    std::vector<NodeId> Stack{Top};
+    while (!Stack.empty()) {
+      auto Node = Stack.back();
+      Stack.pop_back();
+      for (auto Child : Children[Node]) {
+        Depth[Child] = Depth[Node] + 1;
+        Stack.push_back(Child);
+      }
+    }
+  }
+
+  bool insertReachable(NodeId From, NodeId To) {
+    auto NCA = findNCA(From, To);
+    if (NCA == To || NCA == IDom[To])
+      return false;
+
+    auto NCADepth = Depth[NCA];
+    // deepest nodes first
+    std::priority_queue<std::pair<size_type, NodeId>> Bucket;
+    std::vector<NodeId> Visited{To}, Affected, Stack;
+    Bucket.emplace(Depth[To], To);
+    LocalIds[To] = 0; // used as the visited mark
+
+    while (!Bucket.empty()) {
+      auto [CurrDepth, Node] = Bucket.top();
+      Bucket.pop();
+      Affected.push_back(Node);
+      Stack.push_back(Node);
+      while (!Stack.empty()) {
+        auto Next = Stack.back();
+        Stack.pop_back();
+        for (auto Succ : Successors[Next]) {
+          auto SuccDepth = Depth[Succ];
+          if (SuccDepth <= NCADepth + 1 || LocalIds[Succ] != InvalidNodeId)
+            continue;
+          LocalIds[Succ] = 0;
+          Visited.push_back(Succ);
+          if (SuccDepth > CurrDepth)
+            Stack.push_back(Succ);
+          else
+            Bucket.emplace(SuccDepth, Succ);
+        }
+      }
+    }
+
+    for (auto Node : Visited)
+      LocalIds[Node] = InvalidNodeId;
+    for (auto Node : Affected) {
+      setIDom(Node, NCA);
+      updateDepths(Node, NCADepth + 1);
+    }
+    return true;
+  }
+
+  bool insertUnreachable(NodeId From, NodeId To) {
+    // the new edge is the only way into the newly reachable region
+    collectRegion(To, [this](NodeId Node) { return !isReachable(Node); });
+    auto LocalIDom = computeIDomSemiNCA(LocalView{*this});
+
+    setIDom(To, From);
+    for (NodeId Local = 1; Local < LocalNodes.size(); ++Local)
+      setIDom(LocalNodes[Local], LocalNodes[LocalIDom[Local]]);
+    updateDepths(To, Depth[From] + 1);
+
+    // edges leaving the region are insertions into the reachable part
+    std::vector<IdEdgeType> Exits;
+    for (auto Node : LocalNodes)
+      for (auto Succ : Successors[Node])
+        if (LocalIds[Succ] == InvalidNodeId)
+          Exits.emplace_back(Node, Succ);
+    releaseRegion();
+
+    for (auto [ExitFrom, ExitTo] : Exits)
+      insertReachable(ExitFrom, ExitTo);
+    return true;
+  }
+
+  // Recomputes dominators of the subtree of Top, returns whether they have
+  // changed. Old subtree nodes not reached from Top are now unreachable.
+  bool rebuildSubtree(NodeId Top) {
+    auto TopDepth = Depth[Top];
+    collectRegion(Top, [this, TopDepth](NodeId Node) {
+      return isReachable(Node) && Depth[Node] > TopDepth;
+    });
+
+    std::vector<NodeId> Lost;
+    std::vector<NodeId> Stack{Top};
+    while (!Stack.empty()) {
+      auto Node = Stack.back();
+      Stack.pop_back();
+      for (auto Child : Children[Node]) {
+        Stack.push_back(Child);
+        if (LocalIds[Child] == InvalidNodeId)
+          Lost.push_back(Child);
+      }
+    }
+
+    if (!Lost.empty()) {
+      // edges going out of the lost nodes are gone as well, so the nodes
+      // they lead to can change their dominators outside of the subtree
+      auto NewTop = Top;
+      for (auto Node : Lost)
+        for (auto Succ : Successors[Node])
+          if (isReachable(Succ))
+            NewTop = findNCA(NewTop, Succ);
+      for (auto Node : Lost)
+        setIDom(Node, InvalidNodeId);
+      for (auto Node : Lost) {
+        Children[Node].clear();
+        Depth[Node] = 0;
+      }
+      if (NewTop != Top) {
+        releaseRegion();
+        rebuildSubtree(NewTop);
+        return true;
+      }
+    }
+
+    auto LocalIDom = computeIDomSemiNCA(LocalView{*this});
+    bool Changed = !Lost.empty();
+    for (NodeId Local = 1; Local < LocalNodes.size(); ++Local) {
+      auto Node = LocalNodes[Local];
+      auto NewIDom = LocalNodes[LocalIDom[Local]];
+      Changed |= IDom[Node] != NewIDom;
+      setIDom(Node, NewIDom);
+    }
+    releaseRegion();
+
+    updateDepths(Top, TopDepth);
+    return Changed;
+  }
+
+  // DFS from Top through nodes accepted by Filter, assigns local ids
+  template <typename Func> void collectRegion(NodeId Top, Func Filter) {
+    LocalNodes = {Top};
+    LocalIds[Top] = 0;
+    std::vector<NodeId> Stack{Top};
+    while (!Stack.empty()) {
+      auto Node = Stack.back();
+      Stack.pop_back();
+      for (auto Succ : Successors[Node]) {
+        if (LocalIds[Succ] != InvalidNodeId || !Filter(Succ))
+          continue;
+        LocalIds[Succ] = LocalNodes.size();
+        LocalNodes.push_back(Succ);
+        Stack.push_back(Succ);
+      }
+    }
+  }
+
+  void releaseRegion() {
+    for (auto Node : LocalNodes)
+      LocalIds[Node] = InvalidNodeId;
+    LocalNodes.clear();
+  }
+
+  void rebuildFrontiers() {
+    DomFront = computeDominanceFrontiers(*this, IDom);
+    FrontOwners.assign(size(), {});
+    for (NodeId Owner = 0; Owner < size(); ++Owner)
+      for (auto Join : DomFront[Owner])
+        FrontOwners[Join].push_back(Owner);
+  }
+
+  // The tree has not changed: only the entries of Join can be different
+  void updateFrontiersOf(NodeId Join) {
+    for (auto Owner : FrontOwners[Join]) {
+      auto &Front = DomFront[Owner];
+      Front.erase(std::ranges::lower_bound(Front, Join));
+    }
+    FrontOwners[Join].clear();
+    if (!isReachable(Join))
+      return;
+
+    auto Stop = detail::getIDomParent(IDom, Join);
+    for (auto Pred : Predecessors[Join]) {
+      if (!isReachable(Pred))
+        continue;
+      for (auto Runner = Pred; Runner != Stop;
+           Runner = detail::getIDomParent(IDom, Runner)) {
+        auto &Front = DomFront[Runner];
+        auto Pos = std::ranges::lower_bound(Front, Join);
+        if (Pos != Front.end() && *Pos == Join)
+          continue;
+        Front.insert(Pos, Join);
+        FrontOwners[Join].push_back(Runner);
+      }
+    }
+  }
+
+private:
+  NodeId Root;
+  std::vector<std::vector<NodeId>> Successors;
+  std::vector<std::vector<NodeId>> Predecessors;
+
+  IDomArray IDom;
+  std::vector<size_type> Depth;
+  std::vector<std::vector<NodeId>> Children;
+
+  std::vector<std::vector<NodeId>> DomFront;
+  // FrontOwners[j] lists nodes having j in their frontier
+  std::vector<std::vector<NodeId>> FrontOwners;
+
+  // scratch space of the local recomputations, LocalIds is all invalid
+  // between updates
+  std::vector<NodeId> LocalNodes;
+  std::vector<NodeId> LocalIds;
+};
+
+} // namespace graphs
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstring>
+#include <cstddef>
+#include <filesystem>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "csr_graph.hpp"
+#include "name_table.hpp"
+
+namespace graphs {
+
+namespace fs = std::filesystem;
+
+// Read-only memory mapping of a whole file
+class MappedFile final {
+public:
+  explicit MappedFile(const fs::path &Path) {
+    int Fd = ::open(Path.c_str(), O_RDONLY);
+    if (Fd < 0)
+      throw std::runtime_error("can't open file: " + Path.string());
+
+    struct stat Stat;
+    if (::fstat(Fd, &Stat) < 0) {
+      ::close(Fd);
+      throw std::runtime_error("can't stat file: " + Path.string());
+    }
+
+    Size = Stat.st_size;
+    if (Size) {
+      Data = ::mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, Fd, 0);
+      if (Data == MAP_FAILED) {
+        ::close(Fd);
+        throw std::runtime_error("can't map file: " + Path.string());
+      }
+      ::madvise(Data, Size, MADV_SEQUENTIAL);
+    }
+    ::close(Fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&Other) noexcept
+      : Data(std::exchange(Other.Data, nullptr)),
+        Size(std::exchange(Other.Size, 0)) {}
+
+  MappedFile &operator=(MappedFile &&Other) noexcept {
+    std::swap(Data, Other.Data);
+    std::swap(Size, Other.Size);
+    return *this;
+  }
+
+  ~MappedFile() {
+    if (Data)
+      ::munmap(Data, Size);
+  }
+
+  std::string_view getContents() const noexcept {
+    return {static_cast<const char *>(Data), Size};
+  }
+
+private:
+  void *Data = nullptr;
+  std::size_t Size = 0;
+};
+
+namespace detail {
+
+inline std::string_view trimBlanks(std::string_view Str) noexcept {
+  constexpr std::string_view Blanks = " \t\r";
+  auto Begin = Str.find_first_not_of(Blanks);
+  if (Begin == Str.npos)
+    return {};
+  return Str.substr(Begin, Str.find_last_not_of(Blanks) - Begin + 1);
+}
+
+// Reads the next "From --> To" line of [Pos, End) and moves Pos past it,
+// false if no edge is left
+inline bool readEdge(const char *&Pos, const char *End, std::string_view &From,
+                     std::string_view &To) noexcept {
+  static constexpr std::string_view Arrow = "-->";
+
+  while (Pos < End) {
+    auto *LineEnd =
+        static_cast<const char *>(std::memchr(Pos, '\n', End - Pos));
+    if (!LineEnd)
+      LineEnd = End;
+
+    std::string_view Line(Pos, LineEnd - Pos);
+    Pos = LineEnd + 1;
+    if (auto ArrowPos = Line.find(Arrow); ArrowPos != Line.npos) {
+      From = trimBlanks(Line.substr(0, ArrowPos));
+      To = trimBlanks(Line.substr(ArrowPos + Arrow.size()));
+      if (!From.empty() && !To.empty())
+        return true;
+    }
+  }
+  return false;
+}
+
+} // namespace detail
+
+/*
+ * Calls Fn(From, To) for every "From --> To" line of the text. Views point
+ * into the text itself, nothing is copied. Lines are split with memchr,
+ * blank lines and lines without an arrow are skipped.
+ */
+template <typename Func> void parseEdgeList(std::string_view Text, Func Fn) {
+  const char *Pos = Text.data();
+  const char *End = Pos + Text.size();
+  for (std::string_view From, To; detail::readEdge(Pos, End, From, To);)
+    Fn(From, To);
+}
+
+// The edges parseEdgeList gives, one at a time
+class EdgeListIterator final {
+public:
+  using iterator_concept = std::forward_iterator_tag;
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::pair<std::string_view, std::string_view>;
+  using difference_type = std::ptrdiff_t;
+
+  EdgeListIterator() = default;
+  EdgeListIterator(const char *Pos, const char *End) noexcept
+      : Pos(Pos), End(End) {
+    ++*this;
+  }
+
+  const value_type &operator*() const noexcept { return Edge; }
+  const value_type *operator->() const noexcept { return &Edge; }
+
+  EdgeListIterator &operator++() noexcept {
+    // the end iterator has no position
+    if (!detail::readEdge(Pos, End, Edge.first, Edge.second))
+      Pos = End = nullptr;
+    return *this;
+  }
+
+  EdgeListIterator operator++(int) noexcept {
+    auto Tmp = *this;
+    ++*this;
+    return Tmp;
+  }
+
+  bool operator==(const EdgeListIterator &Other) const noexcept {
+    return Pos == Other.Pos;
+  }
+
+private:
+  const char *Pos = nullptr;
+  const char *End = nullptr;
+  value_type Edge;
+};
+
+// Edges of a "From --> To" text parsed on the fly, the names are views
+// into the text
+class EdgeListView final : public std::ranges::view_interface<EdgeListView> {
+public:
+  EdgeListView() = default;
+  explicit EdgeListView(std::string_view Text) noexcept : Text(Text) {}
+
+  EdgeListIterator begin() const noexcept {
+    return {Text.data(), Text.data() + Text.size()};
+  }
+  EdgeListIterator end() const noexcept { return {}; }
+
+private:
+  std::string_view Text;
+};
+
+// Edges with owned names, as expected by the DirectedGraph constructors
+inline std::vector<EdgeType> readEdgeList(const fs::path &Path) {
+  MappedFile File(Path);
+  std::vector<EdgeType> Edges;
+  parseEdgeList(File.getContents(), [&Edges](auto From, auto To) {
+    Edges.emplace_back(From, To);
+  });
+
+  return Edges;
+}
+
+// Names go straight from the text into the name table, whose index is
+// allocated by Alloc
+inline CSRGraph parseCSRGraph(std::string_view Text,
+                              const NameTable::allocator_type &Alloc = {}) {
+  NameTable Names(Alloc);
+  std::vector<EdgeIdType> Edges;
+  // "BB_1 --> BB_2\n" is 14 bytes, good enough to avoid most regrowth
+  Edges.reserve(Text.size() / 14);
+  parseEdgeList(Text, [&](auto From, auto To) {
+    auto FromId = Names.intern(From);
+    Edges.emplace_back(FromId, Names.intern(To));
+  });
+
+  return CSRGraph(std::move(Names), Edges);
+}
+
+inline CSRGraph loadCSRGraph(const fs::path &Path) {
+  MappedFile File(Path);
+  return parseCSRGraph(File.getContents());
+}
+
+} // namespace graphs
@@ -1,25 +1,70 @@
 #pragma once
 
 #include <algorithm>
-#include <fstream>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ostream>
 #include <random>
-#include <set>
+#include <string>
 #include <string_view>
 #include <vector>
 
-#include "utils.hpp"
+#include "thread_pool.hpp"
 
 namespace graphs {
 
+enum class GraphShape : char { Random, Structured };
+
+namespace graph_shape_names {
+
+constexpr std::string_view Random = "random";
+constexpr std::string_view Structured = "structured";
+
+} // namespace graph_shape_names
+
+inline std::optional<GraphShape> getGraphShape(std::string_view Name) {
+  if (Name == graph_shape_names::Random)
+    return GraphShape::Random;
+  if (Name == graph_shape_names::Structured)
+    return GraphShape::Structured;
+  return std::nullopt;
+}
+
+namespace detail {
+
+// Appends "<Name>_<From> --> <Name>_<To>\n"
+inline void printEdge(std::string &Text, std::string_view NodeName,
+                      std::size_t NodeFrom, std::size_t NodeTo) {
+  auto AppendNode = [&](std::size_t Node) {
+    char Digits[24];
+    Text.append(NodeName);
+    Text.push_back('_');
+    Text.append(Digits, std::to_chars(Digits, std::end(Digits), Node).ptr);
+  };
+  AppendNode(NodeFrom);
+  Text.append(" --> ");
+  AppendNode(NodeTo);
+  Text.push_back('\n');
+}
+
+} // namespace detail
+
 class DirGraphBuilder final {
-  using GeneratorType = std::mt19937;
+  using GeneratorType = std::mt19937_64;
 
 public:
   using size_type = std::size_t;
+  using SeedType = std::uint64_t;
 
   static constexpr std::string_view DefNodeName = "BB";
   static constexpr size_type DefNodeNum = 5;
   static constexpr size_type DefEdgeNum = 1;
+  // nodes sharing one random stream
+  static constexpr size_type BlockSize = 4096;
 
   // Generate txt graph into given file:
   // Example graph print (BB is a node's name):
@@ -29,68 +74,130 @@ public:
   //    BB_1 --> BB_1
 
   // Note: if EdgeNum >= NodeNum - got UB possibility
-  static void generateGraph(std::ofstream &OutFile,
+  static void generateGraph(std::ostream &OutFile,
                             size_type NodeNum = DefNodeNum,
                             size_type EdgeNum = DefEdgeNum,
                             std::string_view NodeName = DefNodeName) {
-    if (EdgeNum == 0)
-      return;
-    // create random generator
     std::random_device Device;
-    GeneratorType Engine{Device()};
-
-    std::vector<std::vector<size_type>> Graph(NodeNum);
-    std::set<size_type> FreeNodes;
-    std::generate_n(std::inserter(FreeNodes, FreeNodes.end()), NodeNum - 1,
-                    [&FreeNodes] { return FreeNodes.size() + 1; });
-    // Making tree graph
-    printEdge(OutFile, NodeName, 0, 1);
-    Graph[0].push_back(1);
-    FreeNodes.erase(FreeNodes.begin());
-    for (size_type NodeCount = 1; NodeCount < Graph.size(); ++NodeCount) {
-      if (FreeNodes.empty())
-        break;
-      auto SuccessorsNum = getRandomUnsInt(Engine, 1, EdgeNum);
-      for (size_type SuccessorsCount = 0;
-           SuccessorsCount < SuccessorsNum && !FreeNodes.empty();
-           ++SuccessorsCount) {
-        auto Successor = *FreeNodes.begin();
-        printEdge(OutFile, NodeName, NodeCount, Successor);
-        // saving Successor
-        Graph[NodeCount].push_back(Successor);
-        FreeNodes.erase(FreeNodes.begin());
+    generateGraph(OutFile, NodeNum, EdgeNum, NodeName, Device());
+  }
+
+  /*
+   * Every node n > 0 gets [1, EdgeNum] tree successors, the next unused
+   * nodes in order, while there are any left, and then up to
+   * EdgeNum - (tree successors) random edges to other nodes (having high
+   * possibility to make loops). Node 0 has the only successor 1.
+   *
+   * Random numbers of a block of BlockSize nodes come from streams seeded
+   * by (Seed, block), so blocks are generated in parallel and the output
+   * depends on the seed only, whatever ThreadsCount is. Blocks are
+   * written in order as soon as they are ready, the time is O(N + E).
+   */
+  static void generateGraph(std::ostream &OutFile, size_type NodeNum,
+                            size_type EdgeNum, std::string_view NodeName,
+                            SeedType Seed, size_type ThreadsCount = 1) {
+    if (EdgeNum == 0 || NodeNum < 2)
+      return;
+
+    auto BlocksCount = (NodeNum + BlockSize - 1) / BlockSize;
+    ThreadsCount = std::clamp<size_type>(ThreadsCount, 1, BlocksCount);
+    std::unique_ptr<ThreadPool> Pool;
+    if (ThreadsCount > 1)
+      Pool = std::make_unique<ThreadPool>(ThreadsCount);
+    auto ForBlocks = [&](size_type Begin, size_type End, auto Task) {
+      if (!Pool) {
+        for (auto Block = Begin; Block < End; ++Block)
+          Task(Block);
+        return;
       }
+      for (auto Block = Begin; Block < End; ++Block)
+        Pool->submit([&Task, Block] { Task(Block); });
+      Pool->wait();
+    };
+
+    // Tree successors of node n are [FirstSucc[n], FirstSucc[n] + Count[n])
+    std::vector<std::uint32_t> TreeCount(NodeNum);
+    ForBlocks(0, BlocksCount, [&](size_type Block) {
+      auto Engine = getEngine(Seed, Block, TreeStream);
+      for (auto Node = Block * BlockSize;
+           Node < std::min(NodeNum, (Block + 1) * BlockSize); ++Node)
+        TreeCount[Node] = Node ? getRandomUnsInt(Engine, 1, EdgeNum) : 1;
+    });
+    std::vector<size_type> FirstSucc(NodeNum);
+    for (size_type Node = 0, Next = 1; Node < NodeNum; ++Node) {
+      FirstSucc[Node] = Next;
+      TreeCount[Node] = std::min<size_type>(TreeCount[Node], NodeNum - Next);
+      Next += TreeCount[Node];
     }
-    // Adding random edges (having high possibility to make loops)
-    std::vector<size_type> AllNodes(NodeNum - 1);
-    std::iota(AllNodes.begin(), AllNodes.end(), 1);
-    for (size_type NodeCount = 1; NodeCount < Graph.size(); ++NodeCount) {
-      if (size_type EdgeCount = Graph[NodeCount].size(); EdgeCount < EdgeNum) {
-        auto AddEdgesCount = getRandomUnsInt(Engine, 0, EdgeNum - EdgeCount);
-        std::vector<size_type> Diff;
-        std::set_difference(AllNodes.begin(), AllNodes.end(),
-                            Graph[NodeCount].begin(), Graph[NodeCount].end(),
-                            std::back_inserter(Diff));
-        std::erase(Diff, NodeCount);
-        for (EdgeCount = 0; EdgeCount < AddEdgesCount && !Diff.empty();
-             ++EdgeCount) {
-          auto CellId = getRandomUnsInt(Engine, 0, Diff.size() - 1);
-          auto NodeTo = Diff[CellId];
-          if (NodeCount != NodeTo)
-            printEdge(OutFile, NodeName, NodeCount, NodeTo);
-          Diff.erase(Diff.begin() + CellId);
+
+    // a few blocks per thread are kept in memory at once
+    auto Window = ThreadsCount * 4;
+    std::vector<std::string> Texts(Window);
+    for (size_type Begin = 0; Begin < BlocksCount; Begin += Window) {
+      auto End = std::min(BlocksCount, Begin + Window);
+      ForBlocks(Begin, End, [&](size_type Block) {
+        auto &Text = Texts[Block - Begin];
+        Text.clear();
+        auto Engine = getEngine(Seed, Block, ExtraStream);
+        std::vector<size_type> Extra;
+        for (auto Node = Block * BlockSize;
+             Node < std::min(NodeNum, (Block + 1) * BlockSize); ++Node) {
+          size_type First = FirstSucc[Node], Count = TreeCount[Node];
+          for (auto Succ = First; Succ < First + Count; ++Succ)
+            detail::printEdge(Text, NodeName, Node, Succ);
+          if (Node == 0)
+            continue;
+          chooseExtraSuccessors(Engine, NodeNum, EdgeNum, Node, First, Count,
+                                Extra);
+          for (auto Succ : Extra)
+            detail::printEdge(Text, NodeName, Node, Succ);
         }
-      }
+      });
+      for (auto Block = Begin; Block < End; ++Block)
+        OutFile << Texts[Block - Begin];
     }
   }
 
 private:
-  static void printEdge(std::ofstream &OutFile, std::string_view NodeName,
-                        size_type NodeFrom, size_type NodeTo) {
+  enum StreamKind : unsigned { TreeStream, ExtraStream };
 
-    auto Str = utils::formatPrint("{}_{} --> {}_{}\n", NodeName, NodeFrom,
-                                  NodeName, NodeTo);
-    OutFile << Str;
+  static GeneratorType getEngine(SeedType Seed, size_type Block,
+                                 StreamKind Stream) {
+    std::seed_seq Seq{static_cast<std::uint32_t>(Seed),
+                      static_cast<std::uint32_t>(Seed >> 32),
+                      static_cast<std::uint32_t>(Block),
+                      static_cast<std::uint32_t>(Block >> 32),
+                      static_cast<std::uint32_t>(Stream)};
+    return GeneratorType(Seq);
+  }
+
+  // Distinct random successors out of [1, NodeNum), except the node itself
+  // and its tree successors [First, First + Count)
+  static void chooseExtraSuccessors(GeneratorType &Engine, size_type NodeNum,
+                                    size_type EdgeNum, size_type Node,
+                                    size_type First, size_type Count,
+                                    std::vector<size_type> &Extra) {
+    Extra.clear();
+    if (Count >= EdgeNum)
+      return;
+    auto AddEdgesCount = getRandomUnsInt(Engine, 0, EdgeNum - Count);
+    auto IsExcluded = [&](size_type To) {
+      return To == Node || (To >= First && To < First + Count);
+    };
+
+    auto Available = NodeNum - 2 - Count;
+    if (AddEdgesCount >= Available) {
+      for (size_type To = 1; To < NodeNum; ++To)
+        if (!IsExcluded(To))
+          Extra.push_back(To);
+      return;
+    }
+    // rejections are rare unless the graph is about as small as EdgeNum
+    while (Extra.size() < AddEdgesCount) {
+      auto To = getRandomUnsInt(Engine, 1, NodeNum - 1);
+      if (!IsExcluded(To) && std::ranges::find(Extra, To) == Extra.end())
+        Extra.push_back(To);
+    }
   }
 
   static size_type getRandomUnsInt(GeneratorType &Gener, size_type LowInt,
@@ -100,4 +207,222 @@ private:
   }
 };
 
+// Knobs of StructuredGraphBuilder
+struct CfgShape final {
+  // loops nested in each other, 0 gives acyclic graphs
+  std::size_t MaxLoopDepth = 3;
+  // the largest switch fan-out
+  std::size_t MaxBranching = 4;
+  // mean number of statements in a branch arm or a loop body
+  // (geometrically distributed)
+  std::size_t RegionSize = 4;
+  // percent of loops with a second entry, which makes them irreducible
+  unsigned IrreducibleShare = 0;
+};
+
+/*
+ * Generates CFGs the way a front end lowers structured code. A region is a
+ * sequence of statements, each one is
+ *   - a plain block,
+ *   - if-then or if-else diamond,
+ *   - switch with 2..MaxBranching arms (and sometimes a default edge to
+ *     the join block),
+ *   - while loop with a back edge to its header,
+ *   - early return (an edge to the single exit block), break or continue.
+ * Arms and bodies are regions themselves, nesting gets rarer with depth.
+ * IrreducibleShare percent of loops also get an edge from the block before
+ * the loop into its latch, so neither entry dominates the other.
+ *
+ * The top level region grows until about NodeNum nodes are made, BB_0 is
+ * the entry and BB_1 is the exit. The output depends on the seed only.
+ */
+class StructuredGraphBuilder final {
+  using GeneratorType = std::mt19937_64;
+
+public:
+  using size_type = std::size_t;
+  using SeedType = std::uint64_t;
+
+  // bounds of the CfgShape knobs
+  static constexpr size_type LoopDepthLimit = 16;
+  static constexpr size_type BranchingLimit = 1024;
+  static constexpr size_type RegionSizeLimit = 1024;
+
+  static void generateGraph(std::ostream &OutFile, size_type NodeNum,
+                            std::string_view NodeName, SeedType Seed,
+                            const CfgShape &Shape = {}) {
+    if (NodeNum < 2)
+      return;
+    StructuredGraphBuilder Builder(OutFile, NodeNum, NodeName, Seed, Shape);
+    auto Last = Builder.generateRegion(Entry, 0);
+    Builder.addEdge(Last, Exit);
+    OutFile << Builder.Text;
+  }
+
+private:
+  enum class Statement : char {
+    Plain,
+    Return,
+    Break,
+    Continue,
+    IfThen,
+    IfElse,
+    Switch,
+    Loop
+  };
+
+  struct LoopInfo final {
+    size_type Header;
+    size_type Exit;
+  };
+
+  static constexpr size_type Entry = 0;
+  static constexpr size_type Exit = 1;
+  static constexpr size_type MaxNesting = 32;
+  static constexpr size_type FlushSize = 1 << 16;
+
+  StructuredGraphBuilder(std::ostream &OutFile, size_type NodeNum,
+                         std::string_view NodeName, SeedType Seed,
+                         const CfgShape &Config)
+      : OutFile(OutFile), NodeName(NodeName), NodeNum(NodeNum), Shape(Config) {
+    std::seed_seq Seq{static_cast<std::uint32_t>(Seed),
+                      static_cast<std::uint32_t>(Seed >> 32)};
+    Engine.seed(Seq);
+    Shape.MaxBranching = std::max<size_type>(Shape.MaxBranching, 2);
+    Shape.RegionSize = std::max<size_type>(Shape.RegionSize, 1);
+  }
+
+  bool isFull() const noexcept { return NodesCount >= NodeNum; }
+
+  size_type makeNode() noexcept { return NodesCount++; }
+
+  void addEdge(size_type From, size_type To) {
+    detail::printEdge(Text, NodeName, From, To);
+    if (Text.size() >= FlushSize) {
+      OutFile << Text;
+      Text.clear();
+    }
+  }
+
+  bool getChance(double Probability) {
+    return std::bernoulli_distribution{Probability}(Engine);
+  }
+
+  // Returns the block where control leaves the region
+  size_type generateRegion(size_type Current, size_type Depth) {
+    // the top level region is bounded by the nodes count only
+    auto Length = std::numeric_limits<size_type>::max();
+    if (Depth)
+      Length = 1 + std::geometric_distribution<size_type>{
+                       1.0 / Shape.RegionSize}(Engine);
+    for (size_type Idx = 0; Idx < Length && !isFull(); ++Idx)
+      Current = generateStatement(Current, Depth);
+    return Current;
+  }
+
+  Statement chooseStatement(size_type Depth) {
+    // compound statements get twice rarer with every nesting level
+    if (Depth < MaxNesting && getChance(std::ldexp(0.6, -Depth))) {
+      bool CanLoop = Loops.size() < Shape.MaxLoopDepth;
+      return static_cast<Statement>(static_cast<int>(Statement::IfThen) +
+                                    Compound[CanLoop](Engine));
+    }
+    return static_cast<Statement>(Simple[!Loops.empty()](Engine));
+  }
+
+  size_type generateStatement(size_type Current, size_type Depth) {
+    switch (chooseStatement(Depth)) {
+    case Statement::Plain: {
+      auto Next = makeNode();
+      addEdge(Current, Next);
+      return Next;
+    }
+    case Statement::Return:
+      return generateConditionalJump(Current, Exit, true);
+    case Statement::Break:
+      return generateConditionalJump(Current, Loops.back().Exit);
+    case Statement::Continue:
+      return generateConditionalJump(Current, Loops.back().Header);
+    case Statement::IfThen:
+      return generateBranches(Current, Depth, 1, true);
+    case Statement::IfElse:
+      return generateBranches(Current, Depth, 2, false);
+    case Statement::Switch: {
+      auto ArmsCount = std::uniform_int_distribution<size_type>{
+          2, Shape.MaxBranching}(Engine);
+      return generateBranches(Current, Depth, ArmsCount, getChance(0.5));
+    }
+    case Statement::Loop:
+      return generateLoop(Current, Depth);
+    }
+    return Current;
+  }
+
+  // if (...) { return; | break; | continue; }
+  size_type generateConditionalJump(size_type Current, size_type Target,
+                                    bool WithBlock = false) {
+    if (WithBlock) {
+      auto Block = makeNode();
+      addEdge(Current, Block);
+      addEdge(Block, Target);
+    } else {
+      addEdge(Current, Target);
+    }
+    auto Next = makeNode();
+    addEdge(Current, Next);
+    return Next;
+  }
+
+  // if-then is one arm plus an edge from the condition to the join block
+  size_type generateBranches(size_type Current, size_type Depth,
+                             size_type ArmsCount, bool WithDefault) {
+    std::vector<size_type> Ends;
+    Ends.reserve(ArmsCount);
+    for (size_type Arm = 0; Arm < ArmsCount; ++Arm) {
+      auto Begin = makeNode();
+      addEdge(Current, Begin);
+      Ends.push_back(generateRegion(Begin, Depth + 1));
+    }
+    auto Join = makeNode();
+    if (WithDefault)
+      addEdge(Current, Join);
+    for (auto End : Ends)
+      addEdge(End, Join);
+    return Join;
+  }
+
+  size_type generateLoop(size_type Current, size_type Depth) {
+    auto Header = makeNode();
+    addEdge(Current, Header);
+    auto LoopExit = makeNode();
+    auto Body = makeNode();
+    addEdge(Header, Body);
+
+    Loops.push_back({Header, LoopExit});
+    auto Latch = generateRegion(Body, Depth + 1);
+    Loops.pop_back();
+
+    addEdge(Latch, Header);
+    addEdge(Header, LoopExit);
+    if (getChance(Shape.IrreducibleShare / 100.0))
+      addEdge(Current, Latch);
+    return LoopExit;
+  }
+
+private:
+  std::ostream &OutFile;
+  std::string_view NodeName;
+  size_type NodeNum;
+  CfgShape Shape;
+  GeneratorType Engine;
+  size_type NodesCount = 2;
+  std::vector<LoopInfo> Loops;
+  std::string Text;
+  // weights of IfThen, IfElse, Switch, Loop: [can open a loop]
+  std::discrete_distribution<int> Compound[2] = {{3, 3, 1, 0}, {3, 3, 1, 2}};
+  // weights of Plain, Return, Break, Continue: [inside a loop]
+  std::discrete_distribution<int> Simple[2] = {{8, 1, 0, 0},
+                                               {8, 1, 0.5, 0.5}};
+};
+
 } // namespace graphs
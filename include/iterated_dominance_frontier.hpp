@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "dominance_analysis.hpp"
+#include "dominators.hpp"
+
+namespace graphs {
+
+/*
+ * IDF(S) queries on the DJ-graph (Sreedhar, Gao "A Linear Time Algorithm
+ * for Placing phi-nodes"). Nodes of S go to a bank of per-level buckets
+ * and are taken deepest first. The dominator subtree of a taken node is
+ * visited, and every J-edge y -> z found there with level(z) <= level of
+ * the taken node puts z into the IDF, which joins the bank too. A node is
+ * visited at most once per query, so a query is linear in the DJ-graph.
+ *
+ * The DJ-graph is stored once in CSR form, buckets and marks are kept
+ * between queries, so a query allocates nothing after warming up.
+ */
+class IteratedDominanceFrontier final {
+public:
+  using size_type = std::size_t;
+
+  IteratedDominanceFrontier(const IDomArray &IDom,
+                            std::span<const IdEdgeType> JoinEdges)
+      : Level(IDom.size(), 0), Reachable(IDom.size(), false),
+        Visited(IDom.size(), 0), InPhis(IDom.size(), 0),
+        InDefs(IDom.size(), 0) {
+    auto Size = IDom.size();
+    std::vector<IdEdgeType> TreeEdges;
+    for (NodeId Id = 0; Id < Size; ++Id)
+      if (IDom[Id] != InvalidNodeId && IDom[Id] != Id)
+        TreeEdges.emplace_back(IDom[Id], Id);
+    fillRows(Size, TreeEdges, ChildOffsets, Children);
+    fillRows(Size, JoinEdges, JoinOffsets, JoinTargets);
+
+    // levels in the dominator tree, unreachable nodes are never queued
+    for (NodeId Id = 0; Id < Size; ++Id) {
+      if (IDom[Id] != Id)
+        continue;
+      std::vector<NodeId> Stack{Id};
+      while (!Stack.empty()) {
+        auto Node = Stack.back();
+        Stack.pop_back();
+        Reachable[Node] = true;
+        for (auto Child : getChildren(Node)) {
+          Level[Child] = Level[Node] + 1;
+          MaxLevel = std::max(MaxLevel, Level[Child]);
+          Stack.push_back(Child);
+        }
+      }
+    }
+    Bank.resize(MaxLevel + 1);
+  }
+
+  size_type size() const noexcept { return Level.size(); }
+
+  // Sorted IDF of the definition nodes. The span is valid until the next
+  // query.
+  std::span<const NodeId> calculate(std::span<const NodeId> Defs) {
+    startQuery();
+    Phis.clear();
+    for (auto Def : Defs)
+      if (Def < size() && Reachable[Def] && InDefs[Def] != Stamp) {
+        InDefs[Def] = Stamp;
+        insertNode(Def);
+      }
+
+    while (auto Root = popNode()) {
+      auto RootLevel = Level[*Root];
+      Visited[*Root] = Stamp;
+      Stack.push_back(*Root);
+      while (!Stack.empty()) {
+        auto Node = Stack.back();
+        Stack.pop_back();
+        for (auto Join : getJoinTargets(Node)) {
+          if (Level[Join] > RootLevel || InPhis[Join] == Stamp)
+            continue;
+          InPhis[Join] = Stamp;
+          Phis.push_back(Join);
+          if (InDefs[Join] != Stamp)
+            insertNode(Join);
+        }
+        for (auto Child : getChildren(Node))
+          if (Visited[Child] != Stamp) {
+            Visited[Child] = Stamp;
+            Stack.push_back(Child);
+          }
+      }
+    }
+
+    std::ranges::sort(Phis);
+    return Phis;
+  }
+
+private:
+  static void fillRows(size_type Size, std::span<const IdEdgeType> Edges,
+                       std::vector<std::uint32_t> &Offsets,
+                       std::vector<NodeId> &Targets) {
+    Offsets.assign(Size + 1, 0);
+    for (auto [From, To] : Edges)
+      ++Offsets[From + 1];
+    for (size_type Id = 0; Id < Size; ++Id)
+      Offsets[Id + 1] += Offsets[Id];
+    Targets.resize(Edges.size());
+    auto Pos = Offsets;
+    for (auto [From, To] : Edges)
+      Targets[Pos[From]++] = To;
+  }
+
+  std::span<const NodeId> getChildren(NodeId Id) const noexcept {
+    return std::span(Children).subspan(ChildOffsets[Id],
+                                       ChildOffsets[Id + 1] -
+                                           ChildOffsets[Id]);
+  }
+
+  std::span<const NodeId> getJoinTargets(NodeId Id) const noexcept {
+    return std::span(JoinTargets)
+        .subspan(JoinOffsets[Id], JoinOffsets[Id + 1] - JoinOffsets[Id]);
+  }
+
+  // Marks hold the number of the query they were set by, so nothing has
+  // to be cleared between queries
+  void startQuery() {
+    if (++Stamp == 0) {
+      std::ranges::fill(Visited, 0);
+      std::ranges::fill(InPhis, 0);
+      std::ranges::fill(InDefs, 0);
+      Stamp = 1;
+    }
+    CurrLevel = 0;
+  }
+
+  void insertNode(NodeId Id) {
+    Bank[Level[Id]].push_back(Id);
+    CurrLevel = std::max(CurrLevel, Level[Id]);
+  }
+
+  // deepest node of the bank
+  std::optional<NodeId> popNode() {
+    for (;; --CurrLevel) {
+      if (auto &Bucket = Bank[CurrLevel]; !Bucket.empty()) {
+        auto Id = Bucket.back();
+        Bucket.pop_back();
+        return Id;
+      }
+      if (CurrLevel == 0)
+        return std::nullopt;
+    }
+  }
+
+private:
+  std::vector<std::uint32_t> ChildOffsets;
+  std::vector<NodeId> Children;
+  std::vector<std::uint32_t> JoinOffsets;
+  std::vector<NodeId> JoinTargets;
+  std::vector<std::uint32_t> Level;
+  std::vector<bool> Reachable;
+  std::uint32_t MaxLevel = 0;
+
+  // scratch space reused by the queries
+  std::vector<std::vector<NodeId>> Bank;
+  std::vector<NodeId> Stack;
+  std::vector<NodeId> Phis;
+  std::vector<std::uint32_t> Visited;
+  std::vector<std::uint32_t> InPhis;
+  std::vector<std::uint32_t> InDefs;
+  std::uint32_t Stamp = 0;
+  std::uint32_t CurrLevel = 0;
+};
+
+} // namespace graphs
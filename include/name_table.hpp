@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dominators.hpp"
+
+namespace graphs {
+
+// Interned node names: every distinct name is stored once, in big chunks,
+// and gets a dense id. Views returned by getName stay valid while the
+// table is alive (moving the table keeps them valid too). The chunks, the
+// index and the views all come from the given memory resource.
+class NameTable final {
+public:
+  using size_type = std::size_t;
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+  static constexpr size_type ChunkSize = 1 << 16;
+
+  NameTable() = default;
+  explicit NameTable(const allocator_type &Alloc)
+      : Names(Alloc), Index(Alloc) {}
+
+  NameTable(NameTable &&Other) noexcept
+      : LastChunk(std::exchange(Other.LastChunk, nullptr)),
+        ChunkPtr(std::exchange(Other.ChunkPtr, nullptr)),
+        ChunkFree(std::exchange(Other.ChunkFree, 0)),
+        Names(std::move(Other.Names)), Index(std::move(Other.Index)) {}
+
+  NameTable(const NameTable &) = delete;
+  NameTable &operator=(const NameTable &) = delete;
+
+  ~NameTable() {
+    auto *Resource = getResource();
+    while (LastChunk) {
+      auto *Prev = LastChunk->Prev;
+      Resource->deallocate(LastChunk, sizeof(ChunkHeader) + LastChunk->Size,
+                           alignof(ChunkHeader));
+      LastChunk = Prev;
+    }
+  }
+
+  NodeId intern(std::string_view Name) {
+    if (auto FindIt = Index.find(Name); FindIt != Index.end())
+      return FindIt->second;
+
+    auto Id = static_cast<NodeId>(Names.size());
+    auto Stored = store(Name);
+    Names.push_back(Stored);
+    Index.emplace(Stored, Id);
+    return Id;
+  }
+
+  // InvalidNodeId if the name has not been interned
+  NodeId find(std::string_view Name) const {
+    auto FindIt = Index.find(Name);
+    return FindIt == Index.end() ? InvalidNodeId : FindIt->second;
+  }
+
+  std::string_view getName(NodeId Id) const { return Names[Id]; }
+  const std::pmr::vector<std::string_view> &getNames() const noexcept {
+    return Names;
+  }
+
+  size_type size() const noexcept { return Names.size(); }
+  bool empty() const noexcept { return Names.empty(); }
+
+  void reserve(size_type Count) {
+    Names.reserve(Count);
+    Index.reserve(Count);
+  }
+
+private:
+  // Chunks are linked from the newest one, the names follow the header
+  struct ChunkHeader final {
+    ChunkHeader *Prev;
+    size_type Size;
+  };
+
+  std::pmr::memory_resource *getResource() const noexcept {
+    return Names.get_allocator().resource();
+  }
+
+  std::string_view store(std::string_view Name) {
+    if (Name.size() > ChunkFree) {
+      auto Size = std::max(ChunkSize, Name.size());
+      auto *Chunk = static_cast<ChunkHeader *>(getResource()->allocate(
+          sizeof(ChunkHeader) + Size, alignof(ChunkHeader)));
+      LastChunk = new (Chunk) ChunkHeader{LastChunk, Size};
+      ChunkPtr = reinterpret_cast<char *>(Chunk + 1);
+      ChunkFree = Size;
+    }
+    auto *Begin = std::copy(Name.begin(), Name.end(), ChunkPtr) - Name.size();
+    ChunkPtr += Name.size();
+    ChunkFree -= Name.size();
+    return {Begin, Name.size()};
+  }
+
+private:
+  ChunkHeader *LastChunk = nullptr;
+  char *ChunkPtr = nullptr;
+  size_type ChunkFree = 0;
+  std::pmr::vector<std::string_view> Names;
+  std::pmr::unordered_map<std::string_view, NodeId> Index;
+};
+
+} // namespace graphs
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "directed_graph.hpp"
+#include "dominance_analysis.hpp"
+#include "reversed_graph.hpp"
+
+namespace graphs {
+
+/*
+ * Post-dominator tree. The dominator engines run on the reversed view of
+ * the CFG, whose virtual exit becomes a real node named ExitName once the
+ * analysis is done: it is the root of the tree. If the CFG already has a
+ * node of that name, the exit is named ExitName_1, ExitName_2, ... instead.
+ */
+template <typename T> class PostDomTreeGraph : public DirectedGraph<T> {
+protected:
+  using DGT = DirectedGraph<T>;
+  using DGT::Nodes;
+
+public:
+  static constexpr std::string_view ExitName = "EXIT";
+
+  template <InputEdgeIter EdgeIt>
+  PostDomTreeGraph(EdgeIt FBegin, EdgeIt FEnd,
+                   DomAlgo Algo = DomAlgo::Iterative,
+                   const GraphAllocator &Alloc = {})
+      : PostDomTreeGraph(rgs::subrange(FBegin, FEnd), Algo, false, Alloc) {}
+
+  template <CfgSource Source>
+  explicit PostDomTreeGraph(const Source &Cfg,
+                            DomAlgo Algo = DomAlgo::Iterative,
+                            const GraphAllocator &Alloc = {})
+      : PostDomTreeGraph(Cfg, Algo, false, Alloc) {}
+
+  // fixpoint passes made by an iterative engine, 0 for the others
+  std::size_t getDomIterations() const noexcept { return DomIterations; }
+
+  // indexed by node ids, the exit is the last node
+  const IDomArray &getIPDoms() const noexcept { return IPDom; }
+
+protected:
+  template <CfgSource Source>
+  PostDomTreeGraph(const Source &Cfg, DomAlgo Algo, bool WithFrontiers,
+                   const GraphAllocator &Alloc)
+      : DGT(Cfg, Alloc) {
+    {
+      ReversedGraphView Rev(static_cast<const DGT &>(*this));
+      IPDom = computeIDom(Rev, Algo, Rev.getExit(), &DomIterations);
+      if (WithFrontiers)
+        PostDomFront = computeFrontierTable(Rev, IPDom);
+    }
+
+    Nodes.push_back(DGT::makeNode(DGT::internName(makeExitName())));
+    DGT::clearGraphThreads();
+    for (NodeId Id = 0; Id < IPDom.size(); ++Id)
+      if (IPDom[Id] != InvalidNodeId && IPDom[Id] != Id)
+        Nodes[IPDom[Id]]->addSuccessor(Nodes[Id].get());
+  }
+
+protected:
+  IDomArray IPDom;
+  FrontierTable PostDomFront;
+
+private:
+  // ExitName with the first suffix no CFG node has taken
+  std::string makeExitName() const {
+    std::string Name(ExitName);
+    for (std::size_t Suffix = 1; DGT::findNodeId(Name) != InvalidNodeId;
+         ++Suffix)
+      Name = std::string(ExitName) + "_" + std::to_string(Suffix);
+    return Name;
+  }
+
+  std::size_t DomIterations = 0;
+};
+
+// Post-dominance frontiers: edges n -> m for every m in PDF(n)
+template <typename T>
+class PostDomFrontierGraph final : protected PostDomTreeGraph<T> {
+  using PDTG = PostDomTreeGraph<T>;
+  using PDTG::Nodes;
+  using PDTG::PostDomFront;
+  using typename PDTG::DGT;
+
+public:
+  using typename PDTG::allocator_type;
+  using PDTG::getAllocator;
+  using PDTG::getDomIterations;
+  using PDTG::getIPDoms;
+
+  template <InputEdgeIter EdgeIt>
+  PostDomFrontierGraph(EdgeIt FBegin, EdgeIt FEnd,
+                       DomAlgo Algo = DomAlgo::Iterative,
+                       const allocator_type &Alloc = {})
+      : PostDomFrontierGraph(rgs::subrange(FBegin, FEnd), Algo, Alloc) {}
+
+  template <CfgSource Source>
+  explicit PostDomFrontierGraph(const Source &Cfg,
+                                DomAlgo Algo = DomAlgo::Iterative,
+                                const allocator_type &Alloc = {})
+      : PDTG(Cfg, Algo, true, Alloc) {
+    DGT::clearGraphThreads();
+    for (NodeId Id = 0; Id < PostDomFront.size(); ++Id)
+      for (auto Join : PostDomFront.getFrontier(Id))
+        Nodes[Id]->addSuccessor(Nodes[Join].get());
+  }
+
+  void dumpInDotFormat(std::ofstream &DotDump, std::string_view GraphName,
+                       std::string_view NodeShape, std::string_view NodeColor,
+                       std::string_view EdgeShape,
+                       std::string_view EdgeColor,
+                       std::size_t ThreadsCount = 1) const override {
+    DotWriter Writer(DotDump, ThreadsCount);
+    DGT::dumpInDotFormatBaseImpl(Writer, GraphName, NodeShape, NodeColor,
+                                 EdgeShape, EdgeColor);
+    for (auto &UnPtr : Nodes)
+      if (auto *NodePtr = UnPtr.get(); NodePtr->getSuccessorsCount() == 0)
+        Writer.writeNode(NodePtr->getName());
+
+    Writer << "}\n";
+  }
+};
+
+} // namespace graphs
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+namespace graphs {
+
+namespace fs = std::filesystem;
+
+namespace detail {
+
+// Starts Args[0] (looked up in PATH) without a shell, -1 if it can't start
+inline pid_t spawnProcess(const std::vector<std::string> &Args) {
+  std::vector<char *> Argv;
+  for (const auto &Arg : Args)
+    Argv.push_back(const_cast<char *>(Arg.c_str()));
+  Argv.push_back(nullptr);
+
+  pid_t Pid;
+  if (::posix_spawnp(&Pid, Argv[0], nullptr, nullptr, Argv.data(), environ))
+    return -1;
+  return Pid;
+}
+
+// true if the process has exited with 0
+inline bool waitProcess(pid_t Pid) {
+  int Status;
+  while (::waitpid(Pid, &Status, 0) < 0)
+    if (errno != EINTR)
+      return false;
+  return WIFEXITED(Status) && WEXITSTATUS(Status) == 0;
+}
+
+// Waits until any child has exited and returns it, the child is left to be
+// reaped by waitProcess. -1 if there are no children
+inline pid_t waitAnyExit() {
+  siginfo_t Info{};
+  while (::waitid(P_ALL, 0, &Info, WEXITED | WNOWAIT) < 0)
+    if (errno != EINTR)
+      return -1;
+  return Info.si_pid;
+}
+
+} // namespace detail
+
+/*
+ * Renders DOT files with at most MaxProcesses `dot` processes running at
+ * once. submit() returns as soon as the process is started and blocks
+ * only while all the slots are busy, so graphs can be rendered while the
+ * next ones are analysed. A slot is freed by whichever render finishes
+ * first. Safe to use from several threads, no lock is held while waiting.
+ */
+class RenderQueue final {
+public:
+  using size_type = std::size_t;
+
+  static constexpr std::string_view DefFormat = "png";
+
+  explicit RenderQueue(size_type MaxProcesses = 1,
+                       std::string_view Format = DefFormat)
+      : MaxProcesses(std::max<size_type>(MaxProcesses, 1)),
+        Format(Format) {}
+
+  RenderQueue(const RenderQueue &) = delete;
+  RenderQueue &operator=(const RenderQueue &) = delete;
+
+  ~RenderQueue() { wait(); }
+
+  // The image is written next to the DOT file, with the format extension
+  void submit(const fs::path &DotPath) {
+    std::unique_lock Lock(Mutex);
+    while (Running.size() >= MaxProcesses)
+      finishAny(Lock);
+
+    auto OutPath = fs::path(DotPath).replace_extension(Format);
+    auto Pid = detail::spawnProcess(
+        {"dot", "-T" + Format, DotPath.string(), "-o", OutPath.string()});
+    if (Pid < 0)
+      Failed.push_back(DotPath);
+    else
+      Running.push_back({Pid, DotPath});
+  }
+
+  // Waits for every started render, returns the DOT files failed since the
+  // previous call
+  std::vector<fs::path> wait() {
+    std::unique_lock Lock(Mutex);
+    while (!Running.empty())
+      finishAny(Lock);
+    return std::exchange(Failed, {});
+  }
+
+private:
+  struct Job final {
+    pid_t Pid;
+    fs::path DotPath;
+  };
+
+  // Reaps the first render to finish with Lock released. One thread waits
+  // for the processes, the others wait for it on Finished.
+  void finishAny(std::unique_lock<std::mutex> &Lock) {
+    if (Waiting) {
+      Finished.wait(Lock);
+      return;
+    }
+    Waiting = true;
+    auto Pid = Running.front().Pid;
+    Lock.unlock();
+    auto Exited = detail::waitAnyExit();
+    Lock.lock();
+    // a child started by someone else is theirs to reap, so the oldest
+    // render is waited for instead
+    if (std::ranges::find(Running, Exited, &Job::Pid) != Running.end())
+      Pid = Exited;
+    Lock.unlock();
+    bool Succeeded = detail::waitProcess(Pid);
+    Lock.lock();
+
+    Waiting = false;
+    auto It = std::ranges::find(Running, Pid, &Job::Pid);
+    if (!Succeeded)
+      Failed.push_back(std::move(It->DotPath));
+    Running.erase(It);
+    Finished.notify_all();
+  }
+
+  std::mutex Mutex;
+  std::condition_variable Finished;
+  bool Waiting = false;
+  std::deque<Job> Running;
+  std::vector<fs::path> Failed;
+  size_type MaxProcesses;
+  std::string Format;
+};
+
+} // namespace graphs
@@ -0,0 +1,456 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "dominance_analysis.hpp"
+#include "dominators.hpp"
+#include "edge_list_parser.hpp"
+#include "statistics.hpp"
+
+namespace graphs {
+
+namespace fs = std::filesystem;
+
+namespace detail {
+
+// Streaming XXH64 (the reference algorithm, little-endian reads on any host)
+class XXHash64 final {
+public:
+  explicit XXHash64(std::uint64_t Seed = 0) noexcept
+      : Acc{Seed + P1 + P2, Seed + P2, Seed, Seed - P1}, Seed(Seed) {}
+
+  void update(std::string_view Data) noexcept {
+    if (Data.empty())
+      return;
+    const char *Ptr = Data.data();
+    auto Size = Data.size();
+    TotalLen += Size;
+    if (BufSize + Size < StripeSize) {
+      std::memcpy(Buf.data() + BufSize, Ptr, Size);
+      BufSize += Size;
+      return;
+    }
+    if (BufSize) {
+      auto Fill = StripeSize - BufSize;
+      std::memcpy(Buf.data() + BufSize, Ptr, Fill);
+      consume(Buf.data());
+      Ptr += Fill;
+      Size -= Fill;
+      BufSize = 0;
+    }
+    for (; Size >= StripeSize; Ptr += StripeSize, Size -= StripeSize)
+      consume(Ptr);
+    std::memcpy(Buf.data(), Ptr, Size);
+    BufSize = Size;
+  }
+
+  std::uint64_t digest() const noexcept {
+    std::uint64_t Hash;
+    if (TotalLen >= StripeSize) {
+      Hash = std::rotl(Acc[0], 1) + std::rotl(Acc[1], 7) +
+             std::rotl(Acc[2], 12) + std::rotl(Acc[3], 18);
+      for (auto Lane : Acc)
+        Hash = (Hash ^ round(0, Lane)) * P1 + P4;
+    } else {
+      Hash = Seed + P5;
+    }
+    Hash += TotalLen;
+
+    const char *Ptr = Buf.data();
+    auto Rest = BufSize;
+    for (; Rest >= 8; Ptr += 8, Rest -= 8)
+      Hash = std::rotl(Hash ^ round(0, read<std::uint64_t>(Ptr)), 27) * P1 +
+             P4;
+    if (Rest >= 4) {
+      Hash ^= read<std::uint32_t>(Ptr) * P1;
+      Hash = std::rotl(Hash, 23) * P2 + P3;
+      Ptr += 4;
+      Rest -= 4;
+    }
+    for (; Rest; ++Ptr, --Rest)
+      Hash = std::rotl(Hash ^ static_cast<unsigned char>(*Ptr) * P5, 11) * P1;
+
+    Hash ^= Hash >> 33;
+    Hash *= P2;
+    Hash ^= Hash >> 29;
+    Hash *= P3;
+    return Hash ^ (Hash >> 32);
+  }
+
+private:
+  static constexpr std::uint64_t P1 = 0x9E3779B185EBCA87ULL;
+  static constexpr std::uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+  static constexpr std::uint64_t P3 = 0x165667B19E3779F9ULL;
+  static constexpr std::uint64_t P4 = 0x85EBCA77C2B2AE63ULL;
+  static constexpr std::uint64_t P5 = 0x27D4EB2F165667C5ULL;
+  static constexpr std::size_t StripeSize = 32;
+
+  template <typename T> static T read(const char *Ptr) noexcept {
+    T Value;
+    std::memcpy(&Value, Ptr, sizeof(T));
+    if constexpr (std::endian::native == std::endian::big)
+      Value = byteswap(Value);
+    return Value;
+  }
+
+  template <typename T> static T byteswap(T Value) noexcept {
+    T Swapped = 0;
+    for (std::size_t Byte = 0; Byte < sizeof(T); ++Byte, Value >>= 8)
+      Swapped = (Swapped << 8) | (Value & 0xFF);
+    return Swapped;
+  }
+
+  static std::uint64_t round(std::uint64_t Lane, std::uint64_t Input) noexcept {
+    return std::rotl(Lane + Input * P2, 31) * P1;
+  }
+
+  void consume(const char *Stripe) noexcept {
+    for (std::size_t Idx = 0; Idx < Acc.size(); ++Idx)
+      Acc[Idx] = round(Acc[Idx], read<std::uint64_t>(Stripe + 8 * Idx));
+  }
+
+  std::array<std::uint64_t, 4> Acc;
+  std::uint64_t Seed;
+  std::uint64_t TotalLen = 0;
+  std::array<char, StripeSize> Buf{};
+  std::size_t BufSize = 0;
+};
+
+} // namespace detail
+
+/*
+ * Cache keys: XXH64 of the cache format version, the analysis name and the
+ * edge list with blanks around the names trimmed. Edges are hashed in
+ * input order, as it gives the node ids (node 0 is the entry).
+ */
+class CacheKeyBuilder final {
+public:
+  explicit CacheKeyBuilder(std::string_view Analysis,
+                           std::uint32_t Version) noexcept {
+    Hash.update({reinterpret_cast<const char *>(&Version), sizeof(Version)});
+    addName(Analysis);
+  }
+
+  void addEdge(std::string_view From, std::string_view To) noexcept {
+    addName(From);
+    addName(To);
+  }
+
+  std::uint64_t getKey() const noexcept { return Hash.digest(); }
+
+private:
+  // names can't hold '\0', so the edge list can't be read another way
+  void addName(std::string_view Name) noexcept {
+    Hash.update(Name);
+    Hash.update({"", 1});
+  }
+
+  detail::XXHash64 Hash;
+};
+
+/*
+ * On-disk results keyed by content, shared by any number of processes.
+ * Every entry is one file, <key>.dfres in the cache directory:
+ *
+ *   CacheEntryHeader
+ *   idom            uint32[NodesCount]
+ *   DF offsets      uint32[NodesCount + 1], DF targets uint32[FrontiersCount]
+ *
+ * Entries are written to a temporary file and renamed into place, so a
+ * reader sees a whole entry or none. Reading an entry updates its mtime;
+ * once the entries take more than MaxBytes the least recently used ones
+ * are removed. The size of the entries is counted from one scan of the
+ * directory when the cache is opened, the directory is scanned again only
+ * to evict. Unreadable entries are misses.
+ */
+struct CacheEntryHeader final {
+  static constexpr std::array<char, 8> DefMagic = {'D', 'F', 'R', 'E',
+                                                   'S', '\0', '\0', '\0'};
+  static constexpr std::uint32_t ByteOrderMark = 0x01020304;
+
+  std::array<char, 8> Magic = DefMagic;
+  std::uint32_t Version = 0;
+  std::uint32_t ByteOrder = ByteOrderMark;
+  std::uint64_t Key = 0;
+  std::uint64_t NodesCount = 0;
+  std::uint64_t FrontiersCount = 0;
+};
+
+static_assert(sizeof(CacheEntryHeader) % 8 == 0);
+
+class ResultCache final {
+public:
+  using size_type = std::uintmax_t;
+
+  // Bumped whenever the stored results or their layout change
+  static constexpr std::uint32_t FormatVersion = 1;
+  static constexpr std::string_view DominatorsAnalysis = "dominators";
+  static constexpr std::string_view EntryExtension = ".dfres";
+  static constexpr size_type DefMaxBytes = size_type(256) << 20;
+  // temporary files left by killed writers are removed after that
+  static constexpr std::chrono::hours StaleTempAge{1};
+
+  struct Stats final {
+    size_type Hits = 0;
+    size_type Misses = 0;
+    size_type Stores = 0;
+    size_type Evictions = 0;
+  };
+
+  explicit ResultCache(fs::path Dir, size_type MaxBytes = DefMaxBytes)
+      : Dir(std::move(Dir)), MaxBytes(MaxBytes) {
+    fs::create_directories(this->Dir);
+    TotalBytes = scan().second;
+  }
+
+  template <InputEdgeIter InputIt>
+  static std::uint64_t makeKey(InputIt BeginIt, InputIt EndIt,
+                               std::string_view Analysis) {
+    CacheKeyBuilder Builder(Analysis, FormatVersion);
+    for (; BeginIt != EndIt; ++BeginIt) {
+      const auto &Edge = *BeginIt;
+      Builder.addEdge(Edge.first, Edge.second);
+    }
+    return Builder.getKey();
+  }
+
+  // The same key as of the edges of a "From --> To" text
+  static std::uint64_t makeKey(std::string_view Text,
+                               std::string_view Analysis) {
+    CacheKeyBuilder Builder(Analysis, FormatVersion);
+    parseEdgeList(Text, [&Builder](auto From, auto To) {
+      Builder.addEdge(From, To);
+    });
+    return Builder.getKey();
+  }
+
+  // The key of a graph with fixed node ids, e.g. a .dfbin view: the names
+  // in id order, then every edge. It never equals an edge list key.
+  template <NamedIndexedGraph GraphT>
+  static std::uint64_t makeKey(const GraphT &Gr, std::string_view Analysis) {
+    CacheKeyBuilder Builder(Analysis, FormatVersion);
+    Builder.addEdge("", "");
+    for (NodeId Id = 0; Id < Gr.size(); ++Id)
+      Builder.addEdge(Gr.getName(Id), "");
+    for (NodeId Id = 0; Id < Gr.size(); ++Id)
+      for (NodeId To : Gr.getSuccessors(Id))
+        Builder.addEdge(Gr.getName(Id), Gr.getName(To));
+    return Builder.getKey();
+  }
+
+  std::optional<DominanceResult> load(std::uint64_t Key) {
+    GRAPHS_STATS_PHASE("cache.load");
+    auto Path = getEntryPath(Key);
+    auto Result = readEntry(Path, Key);
+    if (!Result) {
+      Misses.fetch_add(1, std::memory_order_relaxed);
+      GRAPHS_STATS_COUNT("cache.misses", 1);
+      return std::nullopt;
+    }
+    std::error_code Error;
+    fs::last_write_time(Path, fs::file_time_type::clock::now(), Error);
+    Hits.fetch_add(1, std::memory_order_relaxed);
+    GRAPHS_STATS_COUNT("cache.hits", 1);
+    return Result;
+  }
+
+  // false if the entry can't be written, the cache is left as it was
+  bool store(std::uint64_t Key, std::span<const NodeId> IDom,
+             const FrontierTable &Frontiers) {
+    GRAPHS_STATS_PHASE("cache.store");
+    auto Path = getEntryPath(Key);
+    auto TempPath = fs::path(Path).concat(
+        "." + std::to_string(::getpid()) + "-" +
+        std::to_string(TempCounter.fetch_add(1, std::memory_order_relaxed)) +
+        ".tmp");
+
+    // an entry of the same key is replaced, its bytes are no longer taken
+    std::error_code Error;
+    auto OldSize = fs::file_size(Path, Error);
+    if (Error)
+      OldSize = 0;
+    if (!writeEntry(TempPath, Key, IDom, Frontiers) ||
+        (fs::rename(TempPath, Path, Error), Error)) {
+      fs::remove(TempPath, Error);
+      return false;
+    }
+    Stores.fetch_add(1, std::memory_order_relaxed);
+    auto Size = getEntrySize(IDom.size(), Frontiers.getEntriesCount());
+    if (TotalBytes.fetch_add(Size - OldSize, std::memory_order_relaxed) +
+            Size - OldSize >
+        MaxBytes)
+      evict();
+    return true;
+  }
+
+  Stats getStats() const noexcept {
+    return {Hits.load(std::memory_order_relaxed),
+            Misses.load(std::memory_order_relaxed),
+            Stores.load(std::memory_order_relaxed),
+            Evictions.load(std::memory_order_relaxed)};
+  }
+
+  const fs::path &getDir() const noexcept { return Dir; }
+
+private:
+  fs::path getEntryPath(std::uint64_t Key) const {
+    std::array<char, 16> Hex;
+    for (auto &Digit : Hex | std::views::reverse) {
+      Digit = "0123456789abcdef"[Key & 0xF];
+      Key >>= 4;
+    }
+    return Dir / (std::string(Hex.begin(), Hex.end()) +
+                  std::string(EntryExtension));
+  }
+
+  static size_type getEntrySize(size_type NodesCount,
+                               size_type FrontiersCount) noexcept {
+    return sizeof(CacheEntryHeader) +
+           sizeof(NodeId) * (2 * NodesCount + 1 + FrontiersCount);
+  }
+
+  static bool writeEntry(const fs::path &Path, std::uint64_t Key,
+                         std::span<const NodeId> IDom,
+                         const FrontierTable &Frontiers) {
+    std::ofstream Os{Path, std::ios::binary};
+    CacheEntryHeader Header{.Version = FormatVersion,
+                            .Key = Key,
+                            .NodesCount = IDom.size(),
+                            .FrontiersCount = Frontiers.getEntriesCount()};
+    auto Write = [&Os](const auto &Data) {
+      std::span Bytes = std::as_bytes(std::span(Data));
+      Os.write(reinterpret_cast<const char *>(Bytes.data()), Bytes.size());
+    };
+    Write(std::span(&Header, 1));
+    Write(IDom);
+    Write(Frontiers.getOffsets());
+    Write(Frontiers.getTargets());
+    Os.close();
+    return static_cast<bool>(Os);
+  }
+
+  static std::optional<DominanceResult> readEntry(const fs::path &Path,
+                                                  std::uint64_t Key) {
+    std::ifstream Is{Path, std::ios::binary};
+    CacheEntryHeader Header;
+    if (!Is.read(reinterpret_cast<char *>(&Header), sizeof(Header)) ||
+        Header.Magic != CacheEntryHeader::DefMagic ||
+        Header.Version != FormatVersion ||
+        Header.ByteOrder != CacheEntryHeader::ByteOrderMark ||
+        Header.Key != Key)
+      return std::nullopt;
+
+    // sizes must match the file before anything is allocated
+    std::error_code Error;
+    auto FileSize = fs::file_size(Path, Error);
+    if (Error || Header.NodesCount > FileSize ||
+        Header.FrontiersCount > FileSize ||
+        FileSize != getEntrySize(Header.NodesCount, Header.FrontiersCount))
+      return std::nullopt;
+
+    IDomArray IDom(Header.NodesCount);
+    std::vector<FrontierTable::OffsetType> Offsets(Header.NodesCount + 1);
+    std::vector<NodeId> Targets(Header.FrontiersCount);
+    auto Read = [&Is](auto &Data) {
+      return static_cast<bool>(
+          Is.read(reinterpret_cast<char *>(Data.data()),
+                  Data.size() * sizeof(typename std::decay_t<
+                                       decltype(Data)>::value_type)));
+    };
+    if (!Read(IDom) || !Read(Offsets) || !Read(Targets) ||
+        Offsets.front() != 0 || Offsets.back() != Targets.size() ||
+        !std::ranges::is_sorted(Offsets))
+      return std::nullopt;
+    auto IsValidId = [Size = IDom.size()](NodeId Id) { return Id < Size; };
+    if (!std::ranges::all_of(Targets, IsValidId) ||
+        !std::ranges::all_of(IDom, [&](NodeId Id) {
+          return Id == InvalidNodeId || IsValidId(Id);
+        }))
+      return std::nullopt;
+
+    return DominanceResult{std::move(IDom),
+                           FrontierTable(std::move(Offsets),
+                                         std::move(Targets))};
+  }
+
+  struct Entry final {
+    fs::file_time_type Time;
+    size_type Size;
+    fs::path Path;
+  };
+
+  // The entries of the directory and their total size, temporary files
+  // left by killed writers are removed on the way
+  std::pair<std::vector<Entry>, size_type> scan() const {
+    std::vector<Entry> Entries;
+    size_type Bytes = 0;
+    auto Now = fs::file_time_type::clock::now();
+
+    std::error_code Error;
+    for (const auto &DirEntry : fs::directory_iterator(Dir, Error)) {
+      auto Time = DirEntry.last_write_time(Error);
+      auto Size = DirEntry.file_size(Error);
+      if (Error)
+        continue;
+      const auto &Path = DirEntry.path();
+      if (Path.extension() == ".tmp" && Now - Time > StaleTempAge)
+        fs::remove(Path, Error);
+      else if (Path.extension() == EntryExtension) {
+        Entries.push_back({Time, Size, Path});
+        Bytes += Size;
+      }
+    }
+    return {std::move(Entries), Bytes};
+  }
+
+  // Least recently used entries go first. The directory is scanned again,
+  // as other processes may add or remove files meanwhile.
+  void evict() {
+    GRAPHS_STATS_PHASE("cache.evict");
+    auto [Entries, Bytes] = scan();
+    if (Bytes > MaxBytes) {
+      std::error_code Error;
+      std::ranges::sort(Entries, std::less{}, &Entry::Time);
+      for (const auto &Old : Entries) {
+        if (Bytes <= MaxBytes)
+          break;
+        if (fs::remove(Old.Path, Error)) {
+          Evictions.fetch_add(1, std::memory_order_relaxed);
+          GRAPHS_STATS_COUNT("cache.evictions", 1);
+        }
+        Bytes -= Old.Size;
+      }
+    }
+    TotalBytes.store(Bytes, std::memory_order_relaxed);
+  }
+
+  fs::path Dir;
+  size_type MaxBytes;
+  // the bytes of the entries as of the last scan and the stores since
+  std::atomic<size_type> TotalBytes = 0;
+  std::atomic<size_type> Hits = 0;
+  std::atomic<size_type> Misses = 0;
+  std::atomic<size_type> Stores = 0;
+  std::atomic<size_type> Evictions = 0;
+  std::atomic<size_type> TempCounter = 0;
+};
+
+} // namespace graphs
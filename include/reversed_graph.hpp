@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "dominators.hpp"
+
+namespace graphs {
+
+namespace rgs = std::ranges;
+
+namespace detail {
+
+// Nodes of Base (if any) followed by the Extra nodes
+template <rgs::range Range>
+  requires rgs::common_range<const Range>
+class ExtendedAdjacency final {
+  using BaseIter = rgs::iterator_t<const Range>;
+
+public:
+  class Iterator final {
+  public:
+    using iterator_concept = std::forward_iterator_tag;
+    using value_type = NodeId;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+    Iterator(BaseIter It, BaseIter End, const NodeId *Extra)
+        : It(It), End(End), Extra(Extra) {}
+
+    NodeId operator*() const {
+      return It != End ? static_cast<NodeId>(*It) : *Extra;
+    }
+
+    Iterator &operator++() {
+      if (It != End)
+        ++It;
+      else
+        ++Extra;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto Tmp = *this;
+      ++*this;
+      return Tmp;
+    }
+
+    bool operator==(const Iterator &) const = default;
+
+  private:
+    BaseIter It{};
+    BaseIter End{};
+    const NodeId *Extra = nullptr;
+  };
+
+  ExtendedAdjacency(std::optional<Range> Base, std::span<const NodeId> Extra)
+      : Base(std::move(Base)), Extra(Extra) {}
+
+  Iterator begin() const {
+    if (!Base)
+      return {BaseIter{}, BaseIter{}, Extra.data()};
+    return {rgs::begin(*Base), rgs::end(*Base), Extra.data()};
+  }
+
+  Iterator end() const {
+    auto BaseEnd = Base ? rgs::end(*Base) : BaseIter{};
+    return {BaseEnd, BaseEnd, Extra.data() + Extra.size()};
+  }
+
+private:
+  std::optional<Range> Base;
+  std::span<const NodeId> Extra;
+};
+
+} // namespace detail
+
+/*
+ * The graph with every edge reversed plus a virtual exit node (id
+ * Gr.size()) which is the entry of the reversed graph: it has an edge to
+ * every node without successors. Nothing is copied, adjacency ranges of
+ * Gr are used in place, so the dominator and frontier engines give
+ * post-dominators and post-dominance frontiers when run on the view from
+ * getExit(). Nodes that can't reach a node without successors (e.g. an
+ * endless loop) stay unreachable from the exit.
+ */
+template <IndexedGraph G> class ReversedGraphView final {
+  using SuccRange = decltype(std::declval<const G &>().getPredecessors(0));
+  using PredRange = decltype(std::declval<const G &>().getSuccessors(0));
+
+public:
+  using size_type = std::size_t;
+
+  explicit ReversedGraphView(const G &Gr)
+      : Gr(Gr), Exit(static_cast<NodeId>(Gr.size())) {
+    for (NodeId Id = 0; Id < Exit; ++Id)
+      if (auto &&Succs = Gr.getSuccessors(Id); rgs::empty(Succs))
+        Sinks.push_back(Id);
+  }
+
+  // IndexedGraph interface
+  size_type size() const noexcept { return Gr.size() + 1; }
+
+  detail::ExtendedAdjacency<SuccRange> getSuccessors(NodeId Id) const {
+    if (Id == Exit)
+      return {std::nullopt, Sinks};
+    return {Gr.getPredecessors(Id), {}};
+  }
+
+  detail::ExtendedAdjacency<PredRange> getPredecessors(NodeId Id) const {
+    if (Id == Exit)
+      return {std::nullopt, {}};
+    auto Succs = Gr.getSuccessors(Id);
+    bool IsSink = rgs::empty(Succs);
+    return {std::move(Succs), std::span(&Exit, IsSink ? 1 : 0)};
+  }
+
+  NodeId getExit() const noexcept { return Exit; }
+  const std::vector<NodeId> &getSinks() const noexcept { return Sinks; }
+
+private:
+  const G &Gr;
+  NodeId Exit;
+  std::vector<NodeId> Sinks;
+};
+
+} // namespace graphs
@@ -0,0 +1,363 @@
+#pragma once
+
+/*
+ * Phase timers and event counters, compiled in only when GRAPHS_STATS is
+ * defined. Otherwise GRAPHS_STATS_PHASE and GRAPHS_STATS_COUNT expand to
+ * nothing and none of the code below is built.
+ *
+ *   GRAPHS_STATS_PHASE("dominators");       // times the enclosing scope
+ *   GRAPHS_STATS_COUNT("dom.dfs_visits", N); // adds N to a counter
+ *   GRAPHS_STATS_THREAD();                   // counts a worker's allocations
+ *
+ * Counters are relaxed atomics looked up once per call site, so hot loops
+ * should sum into a local and count once. Phases are recorded only after
+ * stats::enable(), optionally with the hardware counters of the calling
+ * thread (Linux perf_event_open) over every phase.
+ */
+
+#ifdef GRAPHS_STATS
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "utils.hpp"
+
+namespace graphs::stats {
+
+namespace detail {
+
+// Set by stats::enable(), allocations made before aren't counted
+inline std::atomic<bool> AllocationsCounted = false;
+
+// Allocations of one thread. Only the owner writes them, so counting
+// takes no locked instruction and no shared cache line. It's trivially
+// destructible, so it can be counted into until the thread is gone.
+struct AllocationCounts final {
+  std::atomic<std::uint64_t> Count{0};
+  std::atomic<std::uint64_t> Bytes{0};
+};
+
+static_assert(std::is_trivially_destructible_v<AllocationCounts>);
+
+inline thread_local AllocationCounts ThreadAllocations;
+
+// Links the counts of its thread from Head while the thread runs and adds
+// them to the exited totals when it ends
+class AllocationsTracker final {
+public:
+  AllocationsTracker() {
+    std::lock_guard Lock(Mutex);
+    Next = std::exchange(Head, this);
+  }
+
+  AllocationsTracker(const AllocationsTracker &) = delete;
+  AllocationsTracker &operator=(const AllocationsTracker &) = delete;
+
+  ~AllocationsTracker() {
+    std::lock_guard Lock(Mutex);
+    auto **Link = &Head;
+    while (*Link != this)
+      Link = &(*Link)->Next;
+    *Link = Next;
+    ExitedCount += Counts.Count.load(std::memory_order_relaxed);
+    ExitedBytes += Counts.Bytes.load(std::memory_order_relaxed);
+  }
+
+  // { count, bytes } of the tracked threads
+  static std::pair<std::uint64_t, std::uint64_t> sum() {
+    std::lock_guard Lock(Mutex);
+    std::pair Total(ExitedCount, ExitedBytes);
+    for (auto *Tracker = Head; Tracker; Tracker = Tracker->Next) {
+      Total.first += Tracker->Counts.Count.load(std::memory_order_relaxed);
+      Total.second += Tracker->Counts.Bytes.load(std::memory_order_relaxed);
+    }
+    return Total;
+  }
+
+private:
+  const AllocationCounts &Counts = ThreadAllocations;
+  AllocationsTracker *Next = nullptr;
+
+  static inline std::mutex Mutex;
+  static inline AllocationsTracker *Head = nullptr;
+  static inline std::uint64_t ExitedCount = 0;
+  static inline std::uint64_t ExitedBytes = 0;
+};
+
+inline thread_local AllocationsTracker ThreadTracker;
+
+// The allocations of the calling thread, made before too, are in --stats
+// from now on. Done by stats::enable(), every phase and GRAPHS_STATS_THREAD.
+inline void trackThreadAllocations() { static_cast<void>(&ThreadTracker); }
+
+inline constexpr std::array<std::string_view, 4> HwEventNames = {
+    "cycles", "instructions", "cache_misses", "branch_misses"};
+using HwValues = std::array<std::uint64_t, HwEventNames.size()>;
+
+// Hardware counters of the calling thread, all of them or none
+class HwCounters final {
+public:
+  HwCounters() {
+#ifdef __linux__
+    constexpr std::array<std::uint64_t, HwEventNames.size()> Configs = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (std::size_t Idx = 0; Idx < Configs.size(); ++Idx) {
+      perf_event_attr Attr{};
+      Attr.type = PERF_TYPE_HARDWARE;
+      Attr.size = sizeof(Attr);
+      Attr.config = Configs[Idx];
+      Attr.disabled = Idx == 0;
+      Attr.exclude_kernel = 1;
+      Attr.exclude_hv = 1;
+      Attr.read_format = PERF_FORMAT_GROUP;
+      Fds[Idx] = static_cast<int>(
+          ::syscall(SYS_perf_event_open, &Attr, 0, -1, Fds[0], 0));
+      if (Fds[Idx] < 0) {
+        close();
+        return;
+      }
+    }
+    ::ioctl(Fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(Fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+  }
+
+  HwCounters(const HwCounters &) = delete;
+  HwCounters &operator=(const HwCounters &) = delete;
+
+  ~HwCounters() { close(); }
+
+  bool isValid() const noexcept { return Fds[0] >= 0; }
+
+  bool read(HwValues &Values) const noexcept {
+#ifdef __linux__
+    // { nr, values[nr] }
+    std::array<std::uint64_t, HwEventNames.size() + 1> Buffer{};
+    if (!isValid() ||
+        ::read(Fds[0], Buffer.data(), sizeof(Buffer)) != sizeof(Buffer))
+      return false;
+    std::copy(Buffer.begin() + 1, Buffer.end(), Values.begin());
+    return true;
+#else
+    (void)Values;
+    return false;
+#endif
+  }
+
+private:
+  void close() noexcept {
+#ifdef __linux__
+    for (auto &Fd : Fds)
+      if (Fd >= 0)
+        ::close(std::exchange(Fd, -1));
+#endif
+  }
+
+  std::array<int, HwEventNames.size()> Fds{-1, -1, -1, -1};
+};
+
+struct PhaseRecord final {
+  std::string Name;
+  std::uint64_t Calls = 0;
+  std::chrono::nanoseconds Total{};
+  std::chrono::nanoseconds Max{};
+  std::uint64_t HwCalls = 0;
+  HwValues Hw{};
+};
+
+struct CounterRecord final {
+  explicit CounterRecord(std::string_view Name) : Name(Name) {}
+
+  std::string Name;
+  std::atomic<std::uint64_t> Value{0};
+};
+
+class Registry final {
+public:
+  static Registry &get() {
+    static Registry Instance;
+    return Instance;
+  }
+
+  // The address is stable, deque never moves its elements
+  std::atomic<std::uint64_t> &getCounter(std::string_view Name) {
+    std::lock_guard Lock(Mutex);
+    auto It = std::ranges::find(Counters, Name, &CounterRecord::Name);
+    if (It != Counters.end())
+      return It->Value;
+    return Counters.emplace_back(Name).Value;
+  }
+
+  void addPhase(std::string_view Name, std::chrono::nanoseconds Time,
+                const HwValues *Hw) {
+    std::lock_guard Lock(Mutex);
+    auto It = std::ranges::find(Phases, Name, &PhaseRecord::Name);
+    auto &Phase =
+        It != Phases.end() ? *It : Phases.emplace_back(std::string(Name));
+    ++Phase.Calls;
+    Phase.Total += Time;
+    Phase.Max = std::max(Phase.Max, Time);
+    if (Hw) {
+      ++Phase.HwCalls;
+      for (std::size_t Idx = 0; Idx < Hw->size(); ++Idx)
+        Phase.Hw[Idx] += (*Hw)[Idx];
+    }
+  }
+
+  void dumpJSON(std::ostream &Os) {
+    using Millis = std::chrono::duration<double, std::milli>;
+    std::lock_guard Lock(Mutex);
+    Os << "{\n  \"phases\": [";
+    for (std::size_t Idx = 0; Idx < Phases.size(); ++Idx) {
+      const auto &Phase = Phases[Idx];
+      Os << (Idx ? ",\n" : "\n")
+         << utils::formatPrint("    {{\"name\": \"{}\", \"calls\": {}, "
+                               "\"total_ms\": {}, \"max_ms\": {}",
+                               Phase.Name, Phase.Calls,
+                               Millis(Phase.Total).count(),
+                               Millis(Phase.Max).count());
+      for (std::size_t Event = 0; Phase.HwCalls && Event < Phase.Hw.size();
+           ++Event)
+        Os << utils::formatPrint(", \"{}\": {}", HwEventNames[Event],
+                                 Phase.Hw[Event]);
+      Os << "}";
+    }
+    Os << "\n  ],\n  \"counters\": {";
+    auto PrintCounter = [&, First = true](std::string_view Name,
+                                          std::uint64_t Value) mutable {
+      Os << (First ? "\n" : ",\n")
+         << utils::formatPrint("    \"{}\": {}", Name, Value);
+      First = false;
+    };
+    for (const auto &Counter : Counters)
+      PrintCounter(Counter.Name, Counter.Value.load());
+    auto [AllocCount, AllocBytes] = AllocationsTracker::sum();
+    PrintCounter("alloc.count", AllocCount);
+    PrintCounter("alloc.bytes", AllocBytes);
+    Os << "\n  }\n}\n";
+  }
+
+  bool isEnabled() const noexcept {
+    return Enabled.load(std::memory_order_relaxed);
+  }
+  bool isHwEnabled() const noexcept {
+    return HwEnabled.load(std::memory_order_relaxed);
+  }
+
+  void enable(bool WithHwCounters) noexcept {
+    HwEnabled = WithHwCounters;
+    Enabled = true;
+    AllocationsCounted = true;
+  }
+
+private:
+  Registry() = default;
+
+  std::mutex Mutex;
+  std::deque<PhaseRecord> Phases;
+  std::deque<CounterRecord> Counters;
+  std::atomic<bool> Enabled = false;
+  std::atomic<bool> HwEnabled = false;
+};
+
+} // namespace detail
+
+// Phases are recorded only after this call
+inline void enable(bool WithHwCounters = false) {
+  detail::trackThreadAllocations();
+  detail::Registry::get().enable(WithHwCounters);
+}
+
+inline void dumpJSON(std::ostream &Os) { detail::Registry::get().dumpJSON(Os); }
+
+// Called by the replaceable operator new of an executable, if it has one.
+// Only the counts of the thread are touched, no lock is taken.
+inline void countAllocation(std::size_t Size) noexcept {
+  if (!detail::AllocationsCounted.load(std::memory_order_relaxed))
+    return;
+  auto &Counts = detail::ThreadAllocations;
+  Counts.Count.store(Counts.Count.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+  Counts.Bytes.store(Counts.Bytes.load(std::memory_order_relaxed) + Size,
+                     std::memory_order_relaxed);
+}
+
+class ScopedPhase final {
+  using Clock = std::chrono::steady_clock;
+
+public:
+  explicit ScopedPhase(std::string_view Name) : Name(Name) {
+    auto &Reg = detail::Registry::get();
+    if (!Reg.isEnabled())
+      return;
+    detail::trackThreadAllocations();
+    Active = true;
+    if (Reg.isHwEnabled())
+      Hw.emplace();
+    Start = Clock::now();
+  }
+
+  ScopedPhase(const ScopedPhase &) = delete;
+  ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+  ~ScopedPhase() {
+    if (!Active)
+      return;
+    auto Time = Clock::now() - Start;
+    detail::HwValues Values;
+    bool HasHw = Hw && Hw->read(Values);
+    detail::Registry::get().addPhase(Name, Time, HasHw ? &Values : nullptr);
+  }
+
+private:
+  std::string_view Name;
+  bool Active = false;
+  std::optional<detail::HwCounters> Hw;
+  Clock::time_point Start;
+};
+
+} // namespace graphs::stats
+
+#define GRAPHS_STATS_CONCAT_IMPL(Lhs, Rhs) Lhs##Rhs
+#define GRAPHS_STATS_CONCAT(Lhs, Rhs) GRAPHS_STATS_CONCAT_IMPL(Lhs, Rhs)
+
+#define GRAPHS_STATS_PHASE(Name)                                               \
+  ::graphs::stats::ScopedPhase GRAPHS_STATS_CONCAT(StatsPhase, __LINE__)(Name)
+
+#define GRAPHS_STATS_COUNT(Name, Value)                                        \
+  do {                                                                         \
+    static auto &StatsCounter =                                                \
+        ::graphs::stats::detail::Registry::get().getCounter(Name);             \
+    StatsCounter.fetch_add(Value, std::memory_order_relaxed);                  \
+  } while (false)
+
+#define GRAPHS_STATS_THREAD()                                                  \
+  ::graphs::stats::detail::trackThreadAllocations()
+
+#else
+
+#define GRAPHS_STATS_PHASE(Name) static_cast<void>(0)
+#define GRAPHS_STATS_COUNT(Name, Value) static_cast<void>(sizeof(Value))
+#define GRAPHS_STATS_THREAD() static_cast<void>(0)
+
+#endif
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "statistics.hpp"
+
+namespace graphs {
+
+/*
+ * Fixed-size work-stealing pool. Every worker owns a task deque: it takes
+ * its own tasks from the back and steals from the front of the other
+ * deques when its own one is empty. Tasks submitted from a worker go to
+ * that worker's deque, external submits are spread round-robin.
+ */
+class ThreadPool final {
+public:
+  using size_type = std::size_t;
+  using TaskType = std::function<void()>;
+
+  static size_type getDefThreadsCount() noexcept {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  explicit ThreadPool(size_type ThreadsCount = getDefThreadsCount()) {
+    ThreadsCount = std::max<size_type>(ThreadsCount, 1);
+    for (size_type I = 0; I < ThreadsCount; ++I)
+      Queues.push_back(std::make_unique<WorkQueue>());
+    for (size_type I = 0; I < ThreadsCount; ++I)
+      Workers.emplace_back([this, I] { run(I); });
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard Lock{Mutex};
+      Stop = true;
+    }
+    HasWork.notify_all();
+    for (auto &Worker : Workers)
+      Worker.join();
+  }
+
+  size_type size() const noexcept { return Workers.size(); }
+
+  void submit(TaskType Task) {
+    auto QueueIdx = CurrentPool == this
+                        ? CurrentWorker
+                        : NextQueue.fetch_add(1, std::memory_order_relaxed) %
+                              Queues.size();
+    {
+      auto &Queue = *Queues[QueueIdx];
+      std::lock_guard Lock{Queue.Mutex};
+      Queue.Tasks.push_back(std::move(Task));
+    }
+    {
+      std::lock_guard Lock{Mutex};
+      ++Queued;
+      ++Pending;
+    }
+    HasWork.notify_one();
+  }
+
+  // blocks until every submitted task has finished
+  void wait() {
+    std::unique_lock Lock{Mutex};
+    AllDone.wait(Lock, [this] { return Pending == 0; });
+  }
+
+private:
+  struct WorkQueue final {
+    std::mutex Mutex;
+    std::deque<TaskType> Tasks;
+  };
+
+  void run(size_type WorkerIdx) {
+    GRAPHS_STATS_THREAD();
+    CurrentPool = this;
+    CurrentWorker = WorkerIdx;
+    for (;;) {
+      {
+        std::unique_lock Lock{Mutex};
+        HasWork.wait(Lock, [this] { return Stop || Queued; });
+        if (!Queued)
+          return;
+        // reserve one of the queued tasks, it can only be taken by us
+        --Queued;
+      }
+
+      TaskType Task;
+      while (!tryPop(WorkerIdx, Task))
+        std::this_thread::yield();
+      Task();
+
+      std::lock_guard Lock{Mutex};
+      if (--Pending == 0)
+        AllDone.notify_all();
+    }
+  }
+
+  bool tryPop(size_type WorkerIdx, TaskType &Task) {
+    {
+      auto &Own = *Queues[WorkerIdx];
+      std::lock_guard Lock{Own.Mutex};
+      if (!Own.Tasks.empty()) {
+        Task = std::move(Own.Tasks.back());
+        Own.Tasks.pop_back();
+        return true;
+      }
+    }
+    for (size_type Shift = 1; Shift < Queues.size(); ++Shift) {
+      auto &Victim = *Queues[(WorkerIdx + Shift) % Queues.size()];
+      std::lock_guard Lock{Victim.Mutex};
+      if (!Victim.Tasks.empty()) {
+        Task = std::move(Victim.Tasks.front());
+        Victim.Tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  std::vector<std::unique_ptr<WorkQueue>> Queues;
+  std::vector<std::thread> Workers;
+  std::atomic<size_type> NextQueue = 0;
+
+  std::mutex Mutex;
+  std::condition_variable HasWork;
+  std::condition_variable AllDone;
+  size_type Queued = 0;
+  size_type Pending = 0;
+  bool Stop = false;
+
+  static inline thread_local ThreadPool *CurrentPool = nullptr;
+  static inline thread_local size_type CurrentWorker = 0;
+};
+
+} // namespace graphs
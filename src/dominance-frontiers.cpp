@@ -1,7 +1,15 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <random>
 #include <ranges>
 #include <sstream>
 #include <stdexcept>
@@ -10,10 +18,20 @@
 #include <unordered_map>
 #include <vector>
 
+#include "analysis_server.hpp"
+#include "binary_graph.hpp"
+#include "cfg_analyses.hpp"
 #include "directed_graph.hpp"
 #include "dominance_frontier_graph.hpp"
 #include "dominance_tree_graph.hpp"
+#include "edge_list_parser.hpp"
 #include "graph_generator.hpp"
+#include "iterated_dominance_frontier.hpp"
+#include "post_dominance_graph.hpp"
+#include "render_queue.hpp"
+#include "result_cache.hpp"
+#include "statistics.hpp"
+#include "thread_pool.hpp"
 
 namespace {
 
@@ -28,25 +46,13 @@ using DGT = DirectedGraph<value_type>;
 using DTT = DomTreeGraph<value_type>;
 using DJGT = DomJoinGraph<value_type>;
 using DFT = DomFrontierGraph<value_type>;
+using PDTT = PostDomTreeGraph<value_type>;
+using PDFT = PostDomFrontierGraph<value_type>;
 using DGBT = DirGraphBuilder;
+using SGBT = StructuredGraphBuilder;
 using OptIter = typename std::vector<std::string>::iterator;
 using OptMap = std::unordered_map<std::string_view, std::string>;
 
-std::vector<EdgeType> getGraphEdges(std::ifstream &Ifs) {
-  static constexpr std::string_view Arrow = " --> ";
-
-  std::vector<EdgeType> Edges;
-  std::string Line;
-  while (std::getline(Ifs >> std::ws, Line)) {
-
-    auto FirstPos = Line.find_first_of(Arrow);
-    Edges.emplace_back(Line.substr(0, FirstPos),
-                       Line.substr(FirstPos + Arrow.size(), std::string::npos));
-  }
-
-  return Edges;
-}
-
 struct CommandContext final {
   OptMap &OM;
   const std::string_view Com;
@@ -65,6 +71,23 @@ constexpr std::string_view FileName = "--file-name";
 constexpr std::string_view GraphName = "--graph-name";
 constexpr std::string_view NodeName = "--node-name";
 constexpr std::string_view Arg = "--arg";
+constexpr std::string_view DomAlgoOpt = "--dom-algo";
+constexpr std::string_view Jobs = "--jobs";
+constexpr std::string_view Defs = "--defs";
+constexpr std::string_view Seed = "--seed";
+constexpr std::string_view Shape = "--shape";
+constexpr std::string_view LoopDepth = "--loop-depth";
+constexpr std::string_view Branching = "--branching";
+constexpr std::string_view RegionSize = "--region-size";
+constexpr std::string_view Irreducible = "--irreducible";
+constexpr std::string_view Stats = "--stats";
+constexpr std::string_view StatsHw = "--stats-hw";
+constexpr std::string_view Display = "--display";
+constexpr std::string_view Render = "--render";
+constexpr std::string_view Socket = "--socket";
+constexpr std::string_view Analyses = "--analyses";
+constexpr std::string_view Cache = "--cache";
+constexpr std::string_view CacheSize = "--cache-size";
 
 }; // namespace opts
 
@@ -76,6 +99,7 @@ constexpr std::string_view Cfg = "-g=cfg";
 constexpr std::string_view CfgTxt = "-g=cfg-txt";
 constexpr std::string_view CfgDot = "-g=cfg-dot";
 constexpr std::string_view CfgPng = "-g=cfg-png";
+constexpr std::string_view CfgBin = "-g=cfg-bin";
 constexpr std::string_view DomTree = "-g=dom-tree";
 constexpr std::string_view DomTreeDot = "-g=dom-tree-dot";
 constexpr std::string_view DomTreePng = "-g=dom-tree-png";
@@ -85,6 +109,17 @@ constexpr std::string_view JoinGraphPng = "-g=join-graph-png";
 constexpr std::string_view DomFrontier = "-g=dom-frontier";
 constexpr std::string_view DomFrontierDot= "-g=dom-frontier-dot";
 constexpr std::string_view DomFrontierPng = "-g=dom-frontier-png";
+constexpr std::string_view PostDomTree = "-g=postdom-tree";
+constexpr std::string_view PostDomTreeDot = "-g=postdom-tree-dot";
+constexpr std::string_view PostDomTreePng = "-g=postdom-tree-png";
+constexpr std::string_view PostDomFrontier = "-g=postdom-frontier";
+constexpr std::string_view PostDomFrontierDot = "-g=postdom-frontier-dot";
+constexpr std::string_view PostDomFrontierPng = "-g=postdom-frontier-png";
+constexpr std::string_view Batch = "-g=batch";
+constexpr std::string_view Phi = "-g=phi";
+constexpr std::string_view All = "-g=all";
+constexpr std::string_view Serve = "-g=serve";
+constexpr std::string_view Query = "-g=query";
 
 }; // namespace coms
 
@@ -99,6 +134,7 @@ enum class ComCodes : char {
   CfgPng,
   Cfg,
   CfgTxt,
+  CfgBin,
   DomTreeDot,
   DomTreePng,
   DomTreeTxt,
@@ -108,7 +144,18 @@ enum class ComCodes : char {
   JoinGraphPng,
   DomFrontier,
   DomFrontierDot,
-  DomFrontierPng
+  DomFrontierPng,
+  PostDomTree,
+  PostDomTreeDot,
+  PostDomTreePng,
+  PostDomFrontier,
+  PostDomFrontierDot,
+  PostDomFrontierPng,
+  Batch,
+  Phi,
+  All,
+  Serve,
+  Query
 };
 
 OptMap OptsMap{{opts::Path, "."},
@@ -121,7 +168,24 @@ OptMap OptsMap{{opts::Path, "."},
                {opts::GraphName, std::string(DGT::DefGraphName)},
                {opts::FileName, std::string(DefFileName)},
                {opts::NodeName, std::string(DGBT::DefNodeName)},
-               {opts::Arg, {}}};
+               {opts::Arg, {}},
+               {opts::DomAlgoOpt, std::string(dom_algo_names::SemiNCA)},
+               {opts::Jobs, std::to_string(ThreadPool::getDefThreadsCount())},
+               {opts::Defs, {}},
+               {opts::Seed, {}},
+               {opts::Shape, std::string(graph_shape_names::Random)},
+               {opts::LoopDepth, std::to_string(CfgShape{}.MaxLoopDepth)},
+               {opts::Branching, std::to_string(CfgShape{}.MaxBranching)},
+               {opts::RegionSize, std::to_string(CfgShape{}.RegionSize)},
+               {opts::Irreducible, std::to_string(CfgShape{}.IrreducibleShare)},
+               {opts::Stats, {}},
+               {opts::StatsHw, "off"},
+               {opts::Display, "on"},
+               {opts::Render, "none"},
+               {opts::Socket, {}},
+               {opts::Analyses, "idom,df"},
+               {opts::Cache, {}},
+               {opts::CacheSize, "256"}};
 
 std::unordered_map<std::string_view, ComCodes> ComCodesMap{
     {coms::H, ComCodes::Help},
@@ -131,6 +195,7 @@ std::unordered_map<std::string_view, ComCodes> ComCodesMap{
     {coms::Cfg, ComCodes::Cfg},
     {coms::DomTree, ComCodes::DomTree},
     {coms::CfgTxt, ComCodes::CfgTxt},
+    {coms::CfgBin, ComCodes::CfgBin},
     {coms::DomTreeDot, ComCodes::DomTreeDot},
     {coms::DomTreePng, ComCodes::DomTreePng},
     {coms::JoinGraphPng, ComCodes::JoinGraphPng},
@@ -139,6 +204,17 @@ std::unordered_map<std::string_view, ComCodes> ComCodesMap{
     {coms::DomFrontierDot, ComCodes::DomFrontierDot},
     {coms::DomFrontierPng, ComCodes::DomFrontierPng},
     {coms::DomFrontier, ComCodes::DomFrontier},
+    {coms::PostDomTree, ComCodes::PostDomTree},
+    {coms::PostDomTreeDot, ComCodes::PostDomTreeDot},
+    {coms::PostDomTreePng, ComCodes::PostDomTreePng},
+    {coms::PostDomFrontier, ComCodes::PostDomFrontier},
+    {coms::PostDomFrontierDot, ComCodes::PostDomFrontierDot},
+    {coms::PostDomFrontierPng, ComCodes::PostDomFrontierPng},
+    {coms::Batch, ComCodes::Batch},
+    {coms::Phi, ComCodes::Phi},
+    {coms::All, ComCodes::All},
+    {coms::Serve, ComCodes::Serve},
+    {coms::Query, ComCodes::Query},
 };
 
 ComCodes getComCode(std::string_view Command) {
@@ -153,6 +229,10 @@ void printHelp(std::ostream &Os = std::cout) {
      << "To generate CFG in choosen format use next commands:" << std::endl;
   Os << "|\t" << "-g=cfg-dot\n|\t-g=cfg-png\n|\t-g=cfg-txt\n|\t-g=cfg"
      << std::endl;
+  Os << "|\t"
+     << "-g=cfg-bin - binary graph (.dfbin) with precomputed dominators and "
+        "dominance frontiers"
+     << std::endl;
   Os << "|-"
      << "To generate dominance tree in choosen format use next commands:"
      << std::endl;
@@ -169,12 +249,54 @@ void printHelp(std::ostream &Os = std::cout) {
   Os << "|\t" << "-g=dom-frontier-dot\n|\t-g=dom-frontier-png\n|\t-g=dom-frontier"
      << std::endl;
   Os << "|-"
-     << "Note: commands -g=cfg, -g=dom-tree, -g=join-graph, -g=dom-frontier "
-     "generate all graph formats." << std::endl;
+     << "To generate post-dominance tree and frontier graphs (rooted at a "
+        "virtual EXIT node):"
+     << std::endl;
+  Os << "|\t" << "-g=postdom-tree-dot\n|\t-g=postdom-tree-png\n|\t-g=postdom-tree"
+     << std::endl;
+  Os << "|\t"
+     << "-g=postdom-frontier-dot\n|\t-g=postdom-frontier-png\n|\t-g=postdom-"
+        "frontier"
+     << std::endl;
+  Os << "|-"
+     << "To build CFG, dominance tree, join and frontier graphs at once:"
+     << std::endl;
+  Os << "|\t"
+     << "-g=all - one dominators computation, <file-name>-cfg.dot, "
+        "-dom-tree.dot, -join-graph.dot and -dom-frontier.dot"
+     << std::endl;
+  Os << "|-"
+     << "To build dominance tree, join and frontier graphs for many files:"
+     << std::endl;
+  Os << "|\t"
+     << "-g=batch - --arg is a directory (*.txt and *.dfbin files) or a "
+        "manifest with one file path per line"
+     << std::endl;
+  Os << "|-"
+     << "To place phi-nodes (iterated dominance frontiers) for definition sets:"
+     << std::endl;
+  Os << "|\t"
+     << "-g=phi - --defs is a file with one \"var: BB_1 BB_2 ...\" set per line"
+     << std::endl;
+  Os << "|-"
+     << "To answer analysis requests without restarting the program:"
+     << std::endl;
+  Os << "|\t"
+     << "-g=serve - requests come on stdin (answers on stdout) or, with "
+        "--socket, on a Unix domain socket"
+     << std::endl;
+  Os << "|\t"
+     << "-g=query - sends the --arg graph to the --socket server, prints "
+        "the --analyses results"
+     << std::endl;
+  Os << "|-"
+     << "Note: commands -g=cfg, -g=dom-tree, -g=join-graph, -g=dom-frontier, "
+     "-g=postdom-tree, -g=postdom-frontier generate all graph formats."
+     << std::endl;
   Os << "|-" << "Options:" << std::endl;
   Os << "|\t"
      << "--arg=<>        - generate graph from txt file with graph "
-        "representation."
+        "representation or from .dfbin file."
      << std::endl;
   Os << "|\t" << "--path=<>       - path to create files." << std::endl;
   Os << "|\t" << "--graph-name=<> - set graph name." << std::endl;
@@ -201,6 +323,70 @@ void printHelp(std::ostream &Os = std::cout) {
      << std::endl;
   Os << "|\t" << "--node-name=<>  - set name for nodes. BB setted as default."
      << std::endl;
+  Os << "|\t"
+     << "--dom-algo=<>   - dominators algorithm: lt, seminca, chk or "
+        "iterative (seminca is default)."
+     << std::endl;
+  Os << "|\t"
+     << "--jobs=<>       - number of worker threads for -g=batch, graph "
+        "generation and DOT output (number of cores is default)."
+     << std::endl;
+  Os << "|\t"
+     << "--seed=<>       - seed of the graph generator, the same seed gives "
+        "the same graph (random by default)."
+     << std::endl;
+  Os << "|\t" << "--defs=<>       - definition sets file for -g=phi."
+     << std::endl;
+  Os << "|\t"
+     << "--shape=<>      - generated graph shape: random (is default) or "
+        "structured (diamonds, loops, switches, early returns)."
+     << std::endl;
+  Os << "|\t"
+     << "--loop-depth=<> - structured shape: max loop nesting (3 is default)."
+     << std::endl;
+  Os << "|\t"
+     << "--branching=<>  - structured shape: max switch arms (4 is default)."
+     << std::endl;
+  Os << "|\t"
+     << "--region-size=<> - structured shape: mean statements in a branch or "
+        "loop body (4 is default)."
+     << std::endl;
+  Os << "|\t"
+     << "--irreducible=<> - structured shape: percent of irreducible loops "
+        "(0 is default)."
+     << std::endl;
+  Os << "|\t"
+     << "--display=<>    - off: don't open rendered png files (on is default)."
+     << std::endl;
+  Os << "|\t"
+     << "--render=<>     - -g=all, -g=batch: also render every DOT file to "
+        "the format (png, svg, ...) by up to --jobs dot processes (none is "
+        "default)."
+     << std::endl;
+  Os << "|\t"
+     << "--stats=<>      - write phase times and counters as JSON to the file "
+        "(needs a GRAPHS_STATS build)."
+     << std::endl;
+  Os << "|\t"
+     << "--stats-hw=<>   - on: add hardware counters (perf_event_open) of "
+        "every phase to --stats (off is default)."
+     << std::endl;
+  Os << "|\t"
+     << "--socket=<>     - Unix domain socket of -g=serve and -g=query "
+        "(stdin and stdout for -g=serve by default)."
+     << std::endl;
+  Os << "|\t"
+     << "--analyses=<>   - -g=query: comma separated idom, df, cfg-dot, "
+        "dom-tree-dot, join-graph-dot, dom-frontier-dot (idom,df is default)."
+     << std::endl;
+  Os << "|\t"
+     << "--cache=<>      - directory of the dominators and dominance frontiers "
+        "cache shared by runs (off by default)."
+     << std::endl;
+  Os << "|\t"
+     << "--cache-size=<> - cache size limit in MB, least recently used "
+        "results are evicted (256 is default)."
+     << std::endl;
   Os << "|-"
      << "Note: you can use RGB format for color option (e.g. "
         "--node-color=#ffffff)."
@@ -210,12 +396,32 @@ void printHelp(std::ostream &Os = std::cout) {
 
 template <typename GraphType>
 concept DotGraphType = std::same_as<GraphType, DJGT> ||
-    std::same_as<GraphType, DFT> ||
+    std::same_as<GraphType, DFT> || std::same_as<GraphType, PDFT> ||
     (std::derived_from<GraphType, DGT> &&requires(GraphType Gr,
                                                   std::ofstream Os) {
       {Gr.dumpInDotFormat(Os)};
     });
 
+// Writes a graph of the generator chosen by the options
+void generateGraph(std::ostream &Os, OptMap &OM) {
+  GRAPHS_STATS_PHASE("generate");
+  auto Seed = OM[opts::Seed].empty() ? std::random_device{}()
+                                     : std::stoull(OM[opts::Seed]);
+  if (*getGraphShape(OM[opts::Shape]) == GraphShape::Structured) {
+    CfgShape Shape{.MaxLoopDepth = std::stoul(OM[opts::LoopDepth]),
+                   .MaxBranching = std::stoul(OM[opts::Branching]),
+                   .RegionSize = std::stoul(OM[opts::RegionSize]),
+                   .IrreducibleShare = static_cast<unsigned>(
+                       std::stoul(OM[opts::Irreducible]))};
+    SGBT::generateGraph(Os, std::stoi(OM[opts::NumNodes]), OM[opts::NodeName],
+                        Seed, Shape);
+  } else {
+    DGBT::generateGraph(Os, std::stoi(OM[opts::NumNodes]),
+                        std::stoi(OM[opts::NumEdges]), OM[opts::NodeName],
+                        Seed, std::stoi(OM[opts::Jobs]));
+  }
+}
+
 fs::path generateTxtFormatGraph(OptMap &OM) {
   fs::path FilePath;
   if (FilePath = OM[opts::Arg]; FilePath.string().empty()) {
@@ -223,39 +429,204 @@ fs::path generateTxtFormatGraph(OptMap &OM) {
                    .append(OM[opts::FileName])
                    .replace_extension(".txt");
     std::ofstream TxtFile{FilePath};
-    DGBT::generateGraph(TxtFile, std::stoi(OM[opts::NumNodes]),
-                        std::stoi(OM[opts::NumEdges]), OM[opts::NodeName]);
+    generateGraph(TxtFile, OM);
+    GRAPHS_STATS_COUNT("io.bytes_written",
+                       static_cast<std::uint64_t>(TxtFile.tellp()));
   }
   return FilePath;
 }
 
+// A txt or a binary (.dfbin) graph file. Txt edges are parsed while the
+// graphs are built, the names go from the mapped file to the name tables.
+// A .dfbin graph is a BinaryGraphView, its node ids are kept.
+class GraphFile final {
+public:
+  explicit GraphFile(const fs::path &FilePath) {
+    GRAPHS_STATS_PHASE("parse");
+    if (FilePath.extension() == BinaryGraphExtension)
+      View.emplace(FilePath);
+    else
+      Text.emplace(FilePath);
+  }
+
+  // Fn(Cfg) with a CfgSource of the file
+  template <typename Func> decltype(auto) visit(Func Fn) const {
+    if (Text)
+      return Fn(EdgeListView(Text->getContents()));
+    return Fn(*View);
+  }
+
+private:
+  std::optional<MappedFile> Text;
+  std::optional<BinaryGraphView> View;
+};
+
+fs::path generateBinFormatGraph(CommandContext &CC) {
+  auto FilePath = generateTxtFormatGraph(CC.OM);
+  auto G = [&] {
+    GRAPHS_STATS_PHASE("parse");
+    return loadCSRGraph(FilePath);
+  }();
+  if (CC.OM[opts::Arg].empty())
+    fs::remove(FilePath);
+
+  auto IDom = computeIDom(G, *getDomAlgo(CC.OM[opts::DomAlgoOpt]));
+  auto DomFront = computeFrontierTable(G, IDom);
+  GRAPHS_STATS_PHASE("binary");
+  writeBinaryGraph(FilePath.replace_extension(BinaryGraphExtension), G, &IDom,
+                   &DomFront);
+  GRAPHS_STATS_COUNT("io.bytes_written", fs::file_size(FilePath));
+  return FilePath;
+}
+
+// Graphs which can be built from dominators of a ResultCache
+template <typename GraphType>
+concept CachedGraphType = std::same_as<GraphType, DTT> ||
+    std::same_as<GraphType, DJGT> || std::same_as<GraphType, DFT>;
+
+// --cache: the results of all the runs sharing the directory
+std::optional<ResultCache> openResultCache(const OptMap &OM) {
+  const auto &Dir = OM.at(opts::Cache);
+  if (Dir.empty())
+    return std::nullopt;
+  return std::optional<ResultCache>(std::in_place, Dir,
+                                    std::stoull(OM.at(opts::CacheSize)) << 20);
+}
+
+// Dominators of a graph of ids, edges are put into a CSRGraph first
+template <CfgSource Source>
+DominanceResult computeDominanceResult(const Source &Cfg, DomAlgo Algo) {
+  auto Compute = [Algo](const auto &G) {
+    DominanceResult Result;
+    Result.IDom = computeIDom(G, Algo);
+    Result.Frontiers = computeFrontierTable(G, Result.IDom);
+    return Result;
+  };
+  if constexpr (NamedIndexedGraph<Source>)
+    return Compute(Cfg);
+  else
+    return Compute(CSRGraph(rgs::begin(Cfg), rgs::end(Cfg)));
+}
+
+// Dominators of the edges from the cache, computed and stored on a miss
+template <CfgSource Source>
+DominanceResult getDominanceResult(const Source &Cfg, DomAlgo Algo,
+                                   ResultCache &Cache) {
+  std::uint64_t Key;
+  if constexpr (NamedIndexedGraph<Source>)
+    Key = ResultCache::makeKey(Cfg, ResultCache::DominatorsAnalysis);
+  else
+    Key = ResultCache::makeKey(rgs::begin(Cfg), rgs::end(Cfg),
+                               ResultCache::DominatorsAnalysis);
+  if (auto Cached = Cache.load(Key))
+    return std::move(*Cached);
+
+  auto Result = computeDominanceResult(Cfg, Algo);
+  Cache.store(Key, Result.IDom, Result.Frontiers);
+  return Result;
+}
+
+// Dominators known before the graphs are built: the ones a .dfbin file
+// stores, else the ones of the cache if it's given
+template <CfgSource Source>
+std::optional<DominanceResult>
+findDominanceResult(const Source &Cfg, DomAlgo Algo, ResultCache *Cache) {
+  if constexpr (std::same_as<Source, BinaryGraphView>)
+    if (auto Stored = Cfg.getDominanceResult())
+      return Stored;
+  if (Cache)
+    return getDominanceResult(Cfg, Algo, *Cache);
+  return std::nullopt;
+}
+
+// The graph must not outlive Resource. With Precomputed the dominators
+// aren't computed again.
+template <DotGraphType GraphType, CfgSource Source>
+GraphType makeGraph(const Source &Cfg, DomAlgo Algo,
+                    std::pmr::memory_resource *Resource =
+                        std::pmr::get_default_resource(),
+                    const DominanceResult *Precomputed = nullptr) {
+  GRAPHS_STATS_PHASE("build");
+  GraphAllocator Alloc(Resource);
+  if constexpr (std::constructible_from<GraphType, const Source &, IDomArray,
+                                        const FrontierTable &,
+                                        GraphAllocator>) {
+    if (Precomputed)
+      return GraphType(Cfg, Precomputed->IDom, Precomputed->Frontiers, Alloc);
+  } else if constexpr (std::constructible_from<GraphType, const Source &,
+                                               IDomArray, GraphAllocator>) {
+    if (Precomputed)
+      return GraphType(Cfg, Precomputed->IDom, Alloc);
+  }
+  if constexpr (std::constructible_from<GraphType, const Source &, DomAlgo,
+                                        GraphAllocator>)
+    return GraphType(Cfg, Algo, Alloc);
+  else
+    return GraphType(Cfg, Alloc);
+}
+
+template <DotGraphType GraphType>
+void dumpDotFile(const GraphType &G, const fs::path &DotPath, const OptMap &OM,
+                 std::size_t ThreadsCount = 1) {
+  GRAPHS_STATS_PHASE("dot");
+  std::ofstream DotFile{DotPath};
+  G.dumpInDotFormat(DotFile, OM.at(opts::NodeShape), OM.at(opts::NodeColor),
+                    OM.at(opts::EdgeShape), OM.at(opts::EdgeColor),
+                    OM.at(opts::GraphName), ThreadsCount);
+  GRAPHS_STATS_COUNT("io.bytes_written",
+                     static_cast<std::uint64_t>(DotFile.tellp()));
+}
+
 template <DotGraphType GraphType>
 fs::path generateDotFormatGraph(CommandContext &CC) {
   auto FilePath = generateTxtFormatGraph(CC.OM);
-  std::ifstream TxtFile{FilePath};
-  auto Edges = getGraphEdges(TxtFile);
-  GraphType G(Edges.cbegin(), Edges.cend());
+  GraphFile File(FilePath);
+  auto Algo = *getDomAlgo(CC.OM[opts::DomAlgoOpt]);
+  std::pmr::monotonic_buffer_resource Arena;
+  auto G = File.visit([&](const auto &Cfg) {
+    std::optional<DominanceResult> Known;
+    if constexpr (CachedGraphType<GraphType>) {
+      auto Cache = openResultCache(CC.OM);
+      Known = findDominanceResult(Cfg, Algo, Cache ? &*Cache : nullptr);
+    }
+    return makeGraph<GraphType>(Cfg, Algo, &Arena, Known ? &*Known : nullptr);
+  });
+  if constexpr (requires { G.getDomIterations(); })
+    if (auto Iterations = G.getDomIterations())
+      std::cout << formatPrint("dominators converged in {} iterations",
+                               Iterations)
+                << std::endl;
   if (CC.Com != coms::Cfg && CC.OM[opts::Arg].empty())
     fs::remove(FilePath);
-  std::ofstream DotFile{FilePath.replace_extension(".dot")};
-  G.dumpInDotFormat(DotFile, CC.OM[opts::NodeShape], CC.OM[opts::NodeColor],
-                    CC.OM[opts::EdgeShape], CC.OM[opts::EdgeColor],
-                    CC.OM[opts::GraphName]);
-  DotFile.close();
+  dumpDotFile(G, FilePath.replace_extension(".dot"), CC.OM,
+              std::stoi(CC.OM[opts::Jobs]));
   return FilePath;
 }
 
 template <DotGraphType GraphType>
 void generatePngFormatGraph(CommandContext &CC) {
   auto DotFilePath = generateDotFormatGraph<GraphType>(CC);
-  dumpInPngFormat(DotFilePath);
+  {
+    GRAPHS_STATS_PHASE("png");
+    RenderQueue Renders;
+    Renders.submit(DotFilePath);
+    for (const auto &Failed : Renders.wait())
+      std::cerr << formatPrint("Render error: dot failed on {}",
+                               Failed.string())
+                << std::endl;
+  }
   if (CC.Com != coms::Cfg && CC.Com != coms::DomTree &&
-      CC.Com != coms::JoinGraph && CC.Com != coms::DomFrontier)
+      CC.Com != coms::JoinGraph && CC.Com != coms::DomFrontier &&
+      CC.Com != coms::PostDomTree && CC.Com != coms::PostDomFrontier)
     fs::remove(DotFilePath);
 
-  std::system(
-      formatPrint("display {}", DotFilePath.replace_extension(".png").string())
-          .c_str());
+  if (CC.OM[opts::Display] == "off")
+    return;
+  GRAPHS_STATS_PHASE("display");
+  if (auto Pid = detail::spawnProcess(
+          {"display", DotFilePath.replace_extension(".png").string()});
+      Pid >= 0)
+    detail::waitProcess(Pid);
 }
 
 template <DotGraphType GraphType>
@@ -263,6 +634,327 @@ void generateFullExtensionGraph(CommandContext &CC) {
   generatePngFormatGraph<GraphType>(CC);
 }
 
+// The analyses of Graph with the Known dominators, else with the ones of
+// Cache under Key, else computed (and stored there if Key is given)
+template <NamedIndexedGraph GraphT>
+BasicCfgAnalyses<GraphT>
+makeCfgAnalyses(GraphT Graph, std::optional<DominanceResult> Known,
+                ResultCache *Cache, std::optional<std::uint64_t> Key,
+                DomAlgo Algo, std::size_t ThreadsCount) {
+  if (!Known && Key)
+    Known = Cache->load(*Key);
+  if (Known)
+    return BasicCfgAnalyses<GraphT>(std::move(Graph), std::move(Known->IDom),
+                                    std::move(Known->Frontiers), ThreadsCount);
+
+  BasicCfgAnalyses<GraphT> Analyses(std::move(Graph), Algo, ThreadsCount);
+  if (Key)
+    Cache->store(*Key, Analyses.getIDoms(), Analyses.getFrontiers());
+  return Analyses;
+}
+
+// Fn(Analyses) for a "From --> To" text, parsed once into an arena that is
+// freed with the analyses
+template <typename Func>
+void analyseCfgText(std::string_view Text, const OptMap &OM,
+                    ResultCache *Cache, std::size_t ThreadsCount, Func Fn) {
+  std::pmr::monotonic_buffer_resource Arena;
+  auto Graph = [&] {
+    GRAPHS_STATS_PHASE("parse");
+    return parseCSRGraph(Text, &Arena);
+  }();
+  std::optional<std::uint64_t> Key;
+  if (Cache)
+    Key = ResultCache::makeKey(Text, ResultCache::DominatorsAnalysis);
+  Fn(makeCfgAnalyses(std::move(Graph), std::nullopt, Cache, Key,
+                     *getDomAlgo(OM.at(opts::DomAlgoOpt)), ThreadsCount));
+}
+
+// Fn(Analyses) for a txt or a .dfbin file. A .dfbin graph is used in
+// place, with the dominators it stores if it has them.
+template <typename Func>
+void analyseCfgFile(const fs::path &FilePath, const OptMap &OM,
+                    ResultCache *Cache, std::size_t ThreadsCount, Func Fn) {
+  if (FilePath.extension() != BinaryGraphExtension) {
+    MappedFile File(FilePath);
+    analyseCfgText(File.getContents(), OM, Cache, ThreadsCount, Fn);
+    return;
+  }
+
+  auto View = [&] {
+    GRAPHS_STATS_PHASE("parse");
+    return BinaryGraphView(FilePath);
+  }();
+  auto Stored = View.getDominanceResult();
+  std::optional<std::uint64_t> Key;
+  if (!Stored && Cache)
+    Key = ResultCache::makeKey(View, ResultCache::DominatorsAnalysis);
+  Fn(makeCfgAnalyses(std::move(View), std::move(Stored), Cache, Key,
+                     *getDomAlgo(OM.at(opts::DomAlgoOpt)), ThreadsCount));
+}
+
+// Writes OutPath-<graph>.dot files of the analyses, each one is given to
+// Renders if it's set. The CFG is written only WithCfg.
+template <typename GraphT>
+void dumpAnalyses(const BasicCfgAnalyses<GraphT> &Analyses,
+                  const std::string &OutPath, const OptMap &OM,
+                  std::size_t ThreadsCount, RenderQueue *Renders,
+                  bool WithCfg) {
+  using AnalysesType = BasicCfgAnalyses<GraphT>;
+  DotStyle Style{.GraphName = OM.at(opts::GraphName),
+                 .NodeShape = OM.at(opts::NodeShape),
+                 .NodeColor = OM.at(opts::NodeColor),
+                 .EdgeShape = OM.at(opts::EdgeShape),
+                 .EdgeColor = OM.at(opts::EdgeColor)};
+
+  auto DumpDotFile = [&](std::string_view Suffix, auto Dump) {
+    auto DotPath = OutPath + std::string(Suffix);
+    {
+      GRAPHS_STATS_PHASE("dot");
+      std::ofstream DotFile{DotPath};
+      (Analyses.*Dump)(DotFile, Style, ThreadsCount);
+      GRAPHS_STATS_COUNT("io.bytes_written",
+                         static_cast<std::uint64_t>(DotFile.tellp()));
+    }
+    if (Renders)
+      Renders->submit(DotPath);
+  };
+  if (WithCfg)
+    DumpDotFile("-cfg.dot", &AnalysesType::dumpCfg);
+  DumpDotFile("-dom-tree.dot", &AnalysesType::dumpDomTree);
+  DumpDotFile("-join-graph.dot", &AnalysesType::dumpJoinGraph);
+  DumpDotFile("-dom-frontier.dot", &AnalysesType::dumpDomFrontier);
+}
+
+// -g=all: the CFG is generated into memory (or read from --arg) once and
+// every DOT file comes from one dominator computation
+void generateAllAnalyses(CommandContext &CC) {
+  auto &OM = CC.OM;
+  auto Cache = openResultCache(OM);
+  auto ThreadsCount = std::stoul(OM[opts::Jobs]);
+  auto OutPath = (fs::path(OM[opts::Path]) / OM[opts::FileName]).string();
+  std::optional<RenderQueue> Renders;
+  if (const auto &Format = OM[opts::Render]; Format != "none")
+    Renders.emplace(ThreadsCount, Format);
+
+  auto Dump = [&](const auto &Analyses) {
+    if (auto Iterations = Analyses.getDomIterations())
+      std::cout << formatPrint("dominators converged in {} iterations",
+                               Iterations)
+                << std::endl;
+    dumpAnalyses(Analyses, OutPath, OM, ThreadsCount,
+                 Renders ? &*Renders : nullptr, true);
+  };
+  if (OM[opts::Arg].empty()) {
+    std::ostringstream Text;
+    generateGraph(Text, OM);
+    analyseCfgText(Text.view(), OM, Cache ? &*Cache : nullptr, ThreadsCount,
+                   Dump);
+  } else {
+    analyseCfgFile(OM[opts::Arg], OM, Cache ? &*Cache : nullptr,
+                   ThreadsCount, Dump);
+  }
+
+  if (!Renders)
+    return;
+  GRAPHS_STATS_PHASE("png");
+  for (const auto &Failed : Renders->wait())
+    std::cerr << formatPrint("Render error: dot failed on {}", Failed.string())
+              << std::endl;
+}
+
+// Inputs of -g=batch: graph files of a directory (sorted by name) or the
+// paths listed in a manifest file, one per line
+std::vector<fs::path> getBatchInputs(const fs::path &Arg) {
+  std::vector<fs::path> Inputs;
+  if (fs::is_directory(Arg)) {
+    for (const auto &Entry : fs::directory_iterator(Arg))
+      if (auto Ext = Entry.path().extension();
+          Entry.is_regular_file() &&
+          (Ext == ".txt" || Ext == BinaryGraphExtension))
+        Inputs.push_back(Entry.path());
+    std::ranges::sort(Inputs);
+  } else {
+    std::ifstream Manifest{Arg};
+    for (std::string Line; std::getline(Manifest >> std::ws, Line);)
+      Inputs.emplace_back(Line);
+  }
+  return Inputs;
+}
+
+struct BatchResult final {
+  std::size_t NodesCount = 0;
+  std::size_t EdgesCount = 0;
+  std::chrono::duration<double, std::milli> Time{};
+  std::string Error;
+};
+
+// DOT files are rendered by Renders if it's given, the dominators come
+// from Cache if it's given and are computed once otherwise
+BatchResult analyseBatchInput(const fs::path &Input, const OptMap &OM,
+                              RenderQueue *Renders, ResultCache *Cache) {
+  BatchResult Result;
+  auto Start = std::chrono::steady_clock::now();
+  try {
+    auto OutPath = (fs::path(OM.at(opts::Path)) / Input.stem()).string();
+    analyseCfgFile(Input, OM, Cache, 1, [&](const auto &Analyses) {
+      dumpAnalyses(Analyses, OutPath, OM, 1, Renders, false);
+      Result.NodesCount = Analyses.getGraph().size();
+      Result.EdgesCount = Analyses.getGraph().getEdgesCount();
+    });
+  } catch (const std::exception &Ex) {
+    Result.Error = Ex.what();
+  }
+  Result.Time = std::chrono::steady_clock::now() - Start;
+  return Result;
+}
+
+// Runs the analyses of every input on a thread pool, the summary is printed
+// in input order whatever order the files are finished in. With --render
+// the DOT files are rendered by up to --jobs dot processes meanwhile.
+void runBatch(CommandContext &CC) {
+  auto Inputs = getBatchInputs(CC.OM[opts::Arg]);
+  std::vector<BatchResult> Results(Inputs.size());
+  auto JobsCount = std::stoi(CC.OM[opts::Jobs]);
+
+  std::optional<RenderQueue> Renders;
+  if (const auto &Format = CC.OM[opts::Render]; Format != "none")
+    Renders.emplace(JobsCount, Format);
+  std::vector<fs::path> FailedRenders;
+  auto Cache = openResultCache(CC.OM);
+
+  auto Start = std::chrono::steady_clock::now();
+  {
+    ThreadPool Pool(JobsCount);
+    for (std::size_t Idx = 0; Idx < Inputs.size(); ++Idx)
+      Pool.submit([&, Idx] {
+        Results[Idx] = analyseBatchInput(Inputs[Idx], CC.OM,
+                                         Renders ? &*Renders : nullptr,
+                                         Cache ? &*Cache : nullptr);
+      });
+    Pool.wait();
+    if (Renders)
+      FailedRenders = Renders->wait();
+  }
+  std::chrono::duration<double, std::milli> WallTime =
+      std::chrono::steady_clock::now() - Start;
+
+  std::chrono::duration<double, std::milli> TotalTime{};
+  std::size_t Failed = 0;
+  std::cout << formatPrint("{:<40} {:>10} {:>10} {:>12}\n", "file", "nodes",
+                           "edges", "time, ms");
+  for (std::size_t Idx = 0; Idx < Inputs.size(); ++Idx) {
+    const auto &Result = Results[Idx];
+    TotalTime += Result.Time;
+    if (!Result.Error.empty()) {
+      ++Failed;
+      std::cout << formatPrint("{:<40} error: {}\n", Inputs[Idx].string(),
+                               Result.Error);
+      continue;
+    }
+    std::cout << formatPrint("{:<40} {:>10} {:>10} {:>12.3f}\n",
+                             Inputs[Idx].string(), Result.NodesCount,
+                             Result.EdgesCount, Result.Time.count());
+  }
+  std::cout << formatPrint("files: {}, failed: {}, jobs: {}, total: {:.3f} ms, "
+                           "wall: {:.3f} ms",
+                           Inputs.size(), Failed, CC.OM[opts::Jobs],
+                           TotalTime.count(), WallTime.count())
+            << std::endl;
+  if (Cache) {
+    auto Stats = Cache->getStats();
+    std::cout << formatPrint("cache: {} hits, {} misses, {} evictions",
+                             Stats.Hits, Stats.Misses, Stats.Evictions)
+              << std::endl;
+  }
+  for (const auto &Failed : FailedRenders)
+    std::cout << formatPrint("render error: dot failed on {}", Failed.string())
+              << std::endl;
+}
+
+// Prints the phi-placement set of every "var: BB_1 BB_2 ..." line of --defs.
+// One IDF calculator serves all the lines.
+void printPhiPlacement(CommandContext &CC) {
+  auto FilePath = generateTxtFormatGraph(CC.OM);
+  GraphFile File(FilePath);
+  if (CC.OM[opts::Arg].empty())
+    fs::remove(FilePath);
+
+  auto Algo = *getDomAlgo(CC.OM[opts::DomAlgoOpt]);
+  std::pmr::monotonic_buffer_resource Arena;
+  auto Join = File.visit([&](const auto &Cfg) {
+    auto Cache = openResultCache(CC.OM);
+    auto Known = findDominanceResult(Cfg, Algo, Cache ? &*Cache : nullptr);
+    return makeGraph<DJGT>(Cfg, Algo, &Arena, Known ? &*Known : nullptr);
+  });
+  IteratedDominanceFrontier IDF(Join.getIDoms(), Join.getJoinEdgeIds());
+
+  std::ifstream DefsFile{CC.OM[opts::Defs]};
+  std::vector<NodeId> Defs;
+  for (std::string Line; std::getline(DefsFile, Line);) {
+    auto Colon = Line.find(':');
+    if (Colon == Line.npos)
+      continue;
+    auto Var = Line.substr(0, Colon);
+    std::istringstream NodesStream{Line.substr(Colon + 1)};
+
+    Defs.clear();
+    std::string UnknownNode;
+    for (std::string Node; NodesStream >> Node;) {
+      if (auto Id = Join.findNodeId(Node); Id != InvalidNodeId)
+        Defs.push_back(Id);
+      else
+        UnknownNode = Node;
+    }
+    if (!UnknownNode.empty()) {
+      std::cout << formatPrint("{}: error: unknown node {}\n", Var,
+                               UnknownNode);
+      continue;
+    }
+
+    std::cout << Var << ':';
+    for (auto Phi : IDF.calculate(Defs))
+      std::cout << ' ' << Join.getNode(Phi)->getName();
+    std::cout << '\n';
+  }
+  std::cout.flush();
+}
+
+// -g=serve: the DOT style options and --dom-algo apply to every request,
+// --jobs requests run at once
+void runServer(CommandContext &CC) {
+  auto &OM = CC.OM;
+  DotStyle Style{.GraphName = OM[opts::GraphName],
+                 .NodeShape = OM[opts::NodeShape],
+                 .NodeColor = OM[opts::NodeColor],
+                 .EdgeShape = OM[opts::EdgeShape],
+                 .EdgeColor = OM[opts::EdgeColor]};
+  AnalysisServer Server(*getDomAlgo(OM[opts::DomAlgoOpt]), Style,
+                        std::stoul(OM[opts::Jobs]));
+  if (const auto &Socket = OM[opts::Socket]; !Socket.empty()) {
+    std::cerr << formatPrint("listening on {}", Socket) << std::endl;
+    Server.listen(Socket);
+  } else {
+    Server.serve(STDIN_FILENO, STDOUT_FILENO);
+  }
+  std::cerr << formatPrint("requests served: {}", Server.getHandledCount())
+            << std::endl;
+}
+
+// -g=query: one request of the --arg edge list to a -g=serve server
+void runQuery(CommandContext &CC) {
+  MappedFile File(CC.OM[opts::Arg]);
+  AnalysisClient Client(CC.OM[opts::Socket]);
+  auto Response =
+      Client.request("1", CC.OM[opts::Analyses], File.getContents());
+  if (!Response.Ok) {
+    std::cerr << formatPrint("Server error: {}", Response.Body) << std::endl;
+    return;
+  }
+  std::cout << Response.Body;
+  std::cout.flush();
+}
+
 bool checkCLArgsOnValidity(std::string_view Command) {
   if (!ComCodesMap.contains(Command))
     InputErrors.push_back(formatPrint(
@@ -288,6 +980,80 @@ bool checkCLArgsOnValidity(std::string_view Command) {
     return 0;
   };
 
+  if (const auto &Algo = OptsMap[opts::DomAlgoOpt]; !getDomAlgo(Algo))
+    InputErrors.push_back(formatPrint(
+        "Input error: {}=: unknown algorithm: {}", opts::DomAlgoOpt, Algo));
+
+  CheckIntArgOption(opts::Jobs);
+#ifndef GRAPHS_STATS
+  if (!OptsMap[opts::Stats].empty())
+    InputErrors.push_back(formatPrint(
+        "Input error: {}=: statistics are compiled out, build with "
+        "GRAPHS_STATS",
+        opts::Stats));
+#endif
+  if (const auto &Display = OptsMap[opts::Display];
+      Display != "on" && Display != "off")
+    InputErrors.push_back(formatPrint(
+        "Input error: {}=: invalid argument: {}, must be on or off",
+        opts::Display, Display));
+  if (const auto &Format = OptsMap[opts::Render];
+      Format.empty() || !std::ranges::all_of(Format, [](unsigned char Char) {
+        return std::isalnum(Char);
+      }))
+    InputErrors.push_back(formatPrint(
+        "Input error: {}=: invalid format: {}", opts::Render, Format));
+  if (const auto &Hw = OptsMap[opts::StatsHw]; Hw != "on" && Hw != "off")
+    InputErrors.push_back(formatPrint(
+        "Input error: {}=: invalid argument: {}, must be on or off",
+        opts::StatsHw, Hw));
+  if (const auto &Seed = OptsMap[opts::Seed];
+      Seed.find_first_not_of("0123456789") != Seed.npos)
+    InputErrors.push_back(formatPrint("Input error: {}=: invalid argument: {}, "
+                                      "must be a non-negative integer",
+                                      opts::Seed, Seed));
+  if (const auto &Shape = OptsMap[opts::Shape]; !getGraphShape(Shape))
+    InputErrors.push_back(formatPrint("Input error: {}=: unknown shape: {}",
+                                      opts::Shape, Shape));
+  auto CheckRangeArgOption = [&](std::string_view Option, unsigned long Min,
+                                 unsigned long Max) {
+    const auto &Arg = OptsMap[Option];
+    if (Arg.empty() || Arg.find_first_not_of("0123456789") != Arg.npos ||
+        Arg.size() > 9 || std::stoul(Arg) < Min || std::stoul(Arg) > Max)
+      InputErrors.push_back(
+          formatPrint("Input error: {}=: invalid argument: {}, must be in "
+                      "[{}, {}]",
+                      Option, Arg, Min, Max));
+  };
+  CheckRangeArgOption(opts::LoopDepth, 0, SGBT::LoopDepthLimit);
+  CheckRangeArgOption(opts::Branching, 2, SGBT::BranchingLimit);
+  CheckRangeArgOption(opts::RegionSize, 1, SGBT::RegionSizeLimit);
+  CheckRangeArgOption(opts::Irreducible, 0, 100);
+  CheckRangeArgOption(opts::CacheSize, 1, 1 << 20);
+  if (const auto &Cache = OptsMap[opts::Cache];
+      !Cache.empty() && fs::exists(Cache) && !fs::is_directory(Cache))
+    InputErrors.push_back(formatPrint(
+        "Input error: {}=: {} is not a directory", opts::Cache, Cache));
+  if (Command == coms::Batch && OptsMap[opts::Arg].empty())
+    InputErrors.push_back(formatPrint(
+        "Input error: {} expects a directory or a manifest in {}=", Command,
+        opts::Arg));
+  if (Command == coms::Query &&
+      (OptsMap[opts::Socket].empty() ||
+       !fs::is_regular_file(OptsMap[opts::Arg])))
+    InputErrors.push_back(formatPrint(
+        "Input error: {} expects a server socket in {}= and a graph txt "
+        "file in {}=",
+        Command, opts::Socket, opts::Arg));
+  if (const auto &Analyses = OptsMap[opts::Analyses];
+      !parseServerAnalyses(Analyses))
+    InputErrors.push_back(formatPrint("Input error: {}=: unknown analysis: {}",
+                                      opts::Analyses, Analyses));
+  if (Command == coms::Phi && !fs::is_regular_file(OptsMap[opts::Defs]))
+    InputErrors.push_back(formatPrint(
+        "Input error: {} expects a definition sets file in {}=", Command,
+        opts::Defs));
+
   if (int NumNodes = CheckIntArgOption(opts::NumNodes),
       NumEdges = CheckIntArgOption(opts::NumEdges);
       NumNodes && NumEdges && NumNodes <= NumEdges) {
@@ -301,6 +1067,23 @@ bool checkCLArgsOnValidity(std::string_view Command) {
 
 } // namespace
 
+#ifdef GRAPHS_STATS
+// Every allocation of the program is counted with --stats
+void *operator new(std::size_t Size) {
+  graphs::stats::countAllocation(Size);
+  if (auto *Ptr = std::malloc(Size ? Size : 1))
+    return Ptr;
+  throw std::bad_alloc();
+}
+
+// GCC can't tell the replaced operator new allocates with malloc
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void *Ptr) noexcept { std::free(Ptr); }
+void operator delete(void *Ptr, std::size_t) noexcept { std::free(Ptr); }
+#pragma GCC diagnostic pop
+#endif
+
 int main(int args, char **argv) {
   if (args < 2) {
     std::cerr << "input error: expected command. Try run with -h" << std::endl;
@@ -324,6 +1107,11 @@ int main(int args, char **argv) {
     return ErrorInputCode;
   }
 
+#ifdef GRAPHS_STATS
+  if (!OptsMap[opts::Stats].empty())
+    stats::enable(OptsMap[opts::StatsHw] == "on");
+#endif
+
   CommandContext CC{OptsMap, OptionSet.front()};
   switch (getComCode(CC.Com)) {
   case ComCodes::Help:
@@ -335,6 +1123,9 @@ int main(int args, char **argv) {
   case ComCodes::CfgTxt:
     generateTxtFormatGraph(CC.OM);
     break;
+  case ComCodes::CfgBin:
+    generateBinFormatGraph(CC);
+    break;
   case ComCodes::CfgDot:
     generateDotFormatGraph<DGT>(CC);
     break;
@@ -368,7 +1159,47 @@ int main(int args, char **argv) {
   case ComCodes::DomFrontierPng:
     generatePngFormatGraph<DFT>(CC);
     break;
+  case ComCodes::PostDomTree:
+    generateFullExtensionGraph<PDTT>(CC);
+    break;
+  case ComCodes::PostDomTreeDot:
+    generateDotFormatGraph<PDTT>(CC);
+    break;
+  case ComCodes::PostDomTreePng:
+    generatePngFormatGraph<PDTT>(CC);
+    break;
+  case ComCodes::PostDomFrontier:
+    generateFullExtensionGraph<PDFT>(CC);
+    break;
+  case ComCodes::PostDomFrontierDot:
+    generateDotFormatGraph<PDFT>(CC);
+    break;
+  case ComCodes::PostDomFrontierPng:
+    generatePngFormatGraph<PDFT>(CC);
+    break;
+  case ComCodes::Batch:
+    runBatch(CC);
+    break;
+  case ComCodes::Phi:
+    printPhiPlacement(CC);
+    break;
+  case ComCodes::All:
+    generateAllAnalyses(CC);
+    break;
+  case ComCodes::Serve:
+    runServer(CC);
+    break;
+  case ComCodes::Query:
+    runQuery(CC);
+    break;
   default:
     break;
   }
+
+#ifdef GRAPHS_STATS
+  if (const auto &StatsPath = OptsMap[opts::Stats]; !StatsPath.empty()) {
+    std::ofstream StatsFile{StatsPath};
+    stats::dumpJSON(StatsFile);
+  }
+#endif
 }